@@ -10,3 +10,12 @@ common:
 vs:
 	ADDON_INCLUDES += libs/openvr/include
 	ADDON_LIBS += libs/openvr/lib/win64/openvr_api.lib
+
+linux64:
+	# There is no bundled Linux build of openvr_api. Link a system one
+	# (PROJECT_LDFLAGS = -lopenvr_api in config.make), or define
+	# OFXVIVETRACKER_NO_OPENVR to build with only the synthetic and replay
+	# pose sources, for example on headless test machines.
+	ADDON_INCLUDES += libs/openvr/include
+	# shm_open for the shared memory pose bus, part of libc from glibc 2.34
+	ADDON_LDFLAGS += -lrt
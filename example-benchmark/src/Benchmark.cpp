@@ -0,0 +1,93 @@
+#include "Benchmark.h"
+#include <cstdio>
+#include <ctime>
+
+void Benchmark::addSamples(const std::string& name, const std::string& unit, std::vector<double> samples, uint64_t count) {
+	if (samples.empty()) return;
+	std::sort(samples.begin(), samples.end());
+	double total = 0.0;
+	for (double sample : samples) {
+		total += sample;
+	}
+
+	BenchmarkResult result;
+	result.name = name;
+	result.unit = unit;
+	result.count = count ? count : samples.size();
+	result.mean = total / samples.size();
+	result.p50 = samples[(samples.size() - 1) / 2];
+	result.p99 = samples[size_t((samples.size() - 1) * 0.99)];
+	result.min = samples.front();
+	result.max = samples.back();
+	results.push_back(result);
+}
+
+void Benchmark::addValue(const std::string& name, const std::string& unit, double value) {
+	BenchmarkResult result;
+	result.name = name;
+	result.unit = unit;
+	result.count = 1;
+	result.mean = result.p50 = result.p99 = result.min = result.max = value;
+	results.push_back(result);
+}
+
+const std::vector<BenchmarkResult>& Benchmark::getResults() const {
+	return results;
+}
+
+void Benchmark::log() const {
+	char line[256];
+	for (const auto& result : results) {
+		if (result.count == 1) {
+			snprintf(line, sizeof(line), "%-36s %12.1f %s", result.name.c_str(), result.mean, result.unit.c_str());
+		} else {
+			snprintf(line, sizeof(line), "%-36s mean %10.1f  p50 %10.1f  p99 %10.1f %s", result.name.c_str(), result.mean, result.p50, result.p99, result.unit.c_str());
+		}
+		ofLogNotice("benchmark") << line;
+	}
+}
+
+bool Benchmark::writeJson(const std::string& path) const {
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file) {
+		ofLogError("benchmark") << "Could not write " << path;
+		return false;
+	}
+
+	char timestamp[32];
+	std::time_t now = std::time(nullptr);
+	std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+#if defined(__clang__)
+	const char* compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+	const char* compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+	const char* compiler = "msvc";
+#else
+	const char* compiler = "unknown";
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+	bool sse2 = true;
+#else
+	bool sse2 = false;
+#endif
+
+	// Names and units are plain identifiers, nothing needs escaping
+	fprintf(file, "{\n");
+	fprintf(file, "  \"version\": 1,\n");
+	fprintf(file, "  \"timestamp\": \"%s\",\n", timestamp);
+	fprintf(file, "  \"compiler\": \"%s\",\n", compiler);
+	fprintf(file, "  \"sse2\": %s,\n", sse2 ? "true" : "false");
+	fprintf(file, "  \"results\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult& r = results[i];
+		fprintf(file, "    {\"name\": \"%s\", \"unit\": \"%s\", \"count\": %llu, \"mean\": %.3f, \"p50\": %.3f, \"p99\": %.3f, \"min\": %.3f, \"max\": %.3f}%s\n",
+			r.name.c_str(), r.unit.c_str(), (unsigned long long)r.count, r.mean, r.p50, r.p99, r.min, r.max,
+			i + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "  ]\n");
+	fprintf(file, "}\n");
+	fclose(file);
+	return true;
+}
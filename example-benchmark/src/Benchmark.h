@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ofMain.h"
+#include <chrono>
+
+struct BenchmarkResult {
+	std::string name;
+	std::string unit;
+	uint64_t count;
+	double mean;
+	double p50;
+	double p99;
+	double min;
+	double max;
+};
+
+// Collects timings and throughput figures and writes them as JSON, one
+// object per result, so runs can be compared over time.
+class Benchmark {
+public:
+	// Keeps a value alive so the compiler can't drop the work producing it.
+	template<class T>
+	static void keep(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile char sink;
+		sink = *reinterpret_cast<const volatile char*>(&value);
+#endif
+	}
+
+	// Calls fn(i) in batches of batchSize for about seconds, after a short
+	// warmup. Reports nanoseconds per call; percentiles are over batches.
+	template<class F>
+	void measure(const std::string& name, size_t batchSize, F fn, double seconds = 0.5) {
+		typedef std::chrono::steady_clock Clock;
+		size_t i = 0;
+		auto warmupEnd = Clock::now() + std::chrono::milliseconds(50);
+		while (Clock::now() < warmupEnd) {
+			for (size_t j = 0; j < batchSize; j++) fn(i++);
+		}
+
+		std::vector<double> batches;
+		auto end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+		while (Clock::now() < end) {
+			auto start = Clock::now();
+			for (size_t j = 0; j < batchSize; j++) fn(i++);
+			batches.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() / batchSize);
+		}
+		addSamples(name, "ns", batches, batches.size() * batchSize);
+	}
+
+	// Summarizes individual measurements.
+	void addSamples(const std::string& name, const std::string& unit, std::vector<double> samples, uint64_t count = 0);
+	void addValue(const std::string& name, const std::string& unit, double value);
+
+	const std::vector<BenchmarkResult>& getResults() const;
+	void log() const;
+	bool writeJson(const std::string& path) const;
+
+private:
+	std::vector<BenchmarkResult> results;
+};
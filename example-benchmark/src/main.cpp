@@ -0,0 +1,341 @@
+#include "ofMain.h"
+#include "ofxViveTracker.h"
+#include "ofxViveTrackerCodec.h"
+#include "ofxViveTrackerMath.h"
+#include "ofxViveTrackerPoseBatch.h"
+#include "ofxViveTrackerRecording.h"
+#include "ofxViveTrackerReplaySource.h"
+#include "ofxViveTrackerSyntheticSource.h"
+#include "Benchmark.h"
+#include <random>
+
+// Headless benchmarks of the pose pipeline on the synthetic source:
+//   convert/*     one conversion or filter step, ns per call
+//   update/*      one ofxViveTracker::update(), ns per call
+//   throughput/*  samples per second through the whole pipeline
+// Results are logged and written as JSON to the path given as the first
+// argument, or bin/data/benchmark.json. Exits with 1 if a self-check fails.
+
+namespace {
+	const size_t numInputs = 256;
+
+	std::vector<ofxViveTrackerSample> makeSamples() {
+		std::vector<ofxViveTrackerSample> samples(numInputs);
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < numInputs; i++) {
+			ofxViveTrackerSyntheticSource::State state = ofxViveTrackerSyntheticSource::circle(i % 8, i * 0.001);
+			ofxViveTrackerSample& sample = samples[i];
+			sample.time = start + std::chrono::milliseconds(i);
+			sample.frame = i;
+			sample.index = vr::TrackedDeviceIndex_t(i % 8);
+			sample.pose.bDeviceIsConnected = true;
+			sample.pose.bPoseIsValid = true;
+			sample.pose.eTrackingResult = vr::TrackingResult_Running_OK;
+			ofxViveTrackerMath::toMatrix(state.orientation, state.position, sample.pose.mDeviceToAbsoluteTracking);
+			for (int axis = 0; axis < 3; axis++) {
+				sample.pose.vVelocity.v[axis] = state.velocity[axis];
+				sample.pose.vAngularVelocity.v[axis] = state.angularVelocity[axis];
+			}
+		}
+		return samples;
+	}
+
+	// Every rotation about each axis in 5 degree steps, plus random ones,
+	// so that each branch of the conversion is hit with either sign
+	std::vector<vr::TrackedDevicePose_t> makeRotations() {
+		std::vector<vr::TrackedDevicePose_t> poses;
+		const glm::vec3 axes[] = { glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, 1) };
+		for (const glm::vec3& axis : axes) {
+			for (int degrees = -180; degrees <= 180; degrees += 5) {
+				vr::TrackedDevicePose_t pose = {};
+				ofxViveTrackerMath::toMatrix(glm::angleAxis(glm::radians(float(degrees)), axis), glm::vec3(0.0f), pose.mDeviceToAbsoluteTracking);
+				poses.push_back(pose);
+			}
+		}
+		std::minstd_rand random(1);
+		std::uniform_real_distribution<float> component(-1.0f, 1.0f);
+		while (poses.size() % ofxViveTrackerPoseBatch::maxDevices) {
+			glm::quat q(component(random), component(random), component(random), component(random));
+			vr::TrackedDevicePose_t pose = {};
+			ofxViveTrackerMath::toMatrix(glm::normalize(q), glm::vec3(0.0f), pose.mDeviceToAbsoluteTracking);
+			poses.push_back(pose);
+		}
+		return poses;
+	}
+
+	// toQuat() and the batch kernel replace glm::quat_cast() on the pose
+	// path, so they must give the same quaternions bit for bit
+	bool checkConversions(const std::vector<vr::TrackedDevicePose_t>& poses) {
+		auto differs = [](const glm::quat& a, const glm::quat& b) {
+			return a.w != b.w || a.x != b.x || a.y != b.y || a.z != b.z;
+		};
+
+		bool ok = true;
+		ofxViveTrackerPoseBatch batch;
+		for (size_t start = 0; start + ofxViveTrackerPoseBatch::maxDevices <= poses.size(); start += ofxViveTrackerPoseBatch::maxDevices) {
+			batch.convert(poses.data() + start, ofxViveTrackerPoseBatch::maxDevices);
+			for (size_t i = 0; i < ofxViveTrackerPoseBatch::maxDevices; i++) {
+				const vr::HmdMatrix34_t& mat = poses[start + i].mDeviceToAbsoluteTracking;
+				glm::mat4 m = ofxViveTrackerMath::toMat4(mat);
+				glm::quat expected = glm::quat_cast(m);
+				if (differs(ofxViveTrackerMath::toQuat(mat), expected) || differs(batch.getOrientation(i), expected)) {
+					ofLogError("benchmark") << "Conversion differs from glm::quat_cast() for pose " << start + i;
+					ok = false;
+				}
+				if (memcmp(&m, &batch.getMatrix(i), sizeof(m)) != 0) {
+					ofLogError("benchmark") << "Batch matrix differs from toMat4() for pose " << start + i;
+					ok = false;
+				}
+			}
+		}
+		return ok;
+	}
+
+	bool benchmarkConversions(Benchmark& benchmark) {
+		std::vector<ofxViveTrackerSample> samples = makeSamples();
+		auto matrix = [&](size_t i) -> const vr::HmdMatrix34_t& {
+			return samples[i % numInputs].pose.mDeviceToAbsoluteTracking;
+		};
+
+		// The per-device path before the batch kernel: mat4, then quat_cast
+		benchmark.measure("convert/matrixToQuat", 1000, [&](size_t i) {
+			Benchmark::keep(glm::quat_cast(ofxViveTrackerMath::toMat4(matrix(i))));
+		});
+		benchmark.measure("convert/toMat4", 1000, [&](size_t i) {
+			Benchmark::keep(ofxViveTrackerMath::toMat4(matrix(i)));
+		});
+		benchmark.measure("convert/toQuat", 1000, [&](size_t i) {
+			Benchmark::keep(ofxViveTrackerMath::toQuat(matrix(i)));
+		});
+		// All 64 devices at once, checked against glm first
+		std::vector<vr::TrackedDevicePose_t> poses(numInputs);
+		for (size_t i = 0; i < numInputs; i++) {
+			poses[i] = samples[i].pose;
+		}
+		bool ok = checkConversions(poses) && checkConversions(makeRotations());
+		ofxViveTrackerPoseBatch batch;
+		benchmark.measure("convert/batch64", 10, [&](size_t i) {
+			batch.convert(poses.data() + (i % 4) * ofxViveTrackerPoseBatch::maxDevices, ofxViveTrackerPoseBatch::maxDevices);
+			Benchmark::keep(batch.qw[0]);
+		});
+		benchmark.measure("convert/batch64NoMatrix", 10, [&](size_t i) {
+			batch.convert(poses.data() + (i % 4) * ofxViveTrackerPoseBatch::maxDevices, ofxViveTrackerPoseBatch::maxDevices, false);
+			Benchmark::keep(batch.qw[0]);
+		});
+		benchmark.measure("convert/toMatrix", 1000, [&](size_t i) {
+			vr::HmdMatrix34_t mat;
+			ofxViveTrackerMath::toMatrix(glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(float(i)), mat);
+			Benchmark::keep(mat);
+		});
+
+		ofxViveTrackerCodec encoder, decoder;
+		std::vector<uint8_t> encoded(numInputs * ofxViveTrackerCodec::maxEncodedSize);
+		std::vector<size_t> offsets(numInputs + 1, 0);
+		for (size_t i = 0; i < numInputs; i++) {
+			offsets[i + 1] = offsets[i] + encoder.encode(samples[i], encoded.data() + offsets[i]);
+		}
+		benchmark.measure("convert/codecEncode", numInputs, [&](size_t i) {
+			uint8_t out[ofxViveTrackerCodec::maxEncodedSize];
+			if (i % numInputs == 0) encoder.reset();
+			Benchmark::keep(encoder.encode(samples[i % numInputs], out));
+		});
+		benchmark.measure("convert/codecDecode", numInputs, [&](size_t i) {
+			ofxViveTrackerSample sample;
+			size_t n = i % numInputs;
+			if (n == 0) decoder.reset();
+			decoder.decode(encoded.data() + offsets[n], offsets[n + 1] - offsets[n], sample);
+			Benchmark::keep(sample);
+		});
+
+		ofxViveTrackerOneEuroFilter oneEuro;
+		benchmark.measure("convert/oneEuro64", 100, [&](size_t i) {
+			auto time = samples[0].time + std::chrono::milliseconds(i);
+			for (size_t slot = 0; slot < 64; slot++) {
+				const vr::HmdMatrix34_t& mat = matrix(i + slot);
+				oneEuro.setInput(slot, ofxViveTrackerMath::toPosition(mat), ofxViveTrackerMath::toQuat(mat), time);
+			}
+			oneEuro.apply(64);
+			Benchmark::keep(oneEuro.getPosition(0));
+		});
+
+		ofxViveTrackerKalmanFilter kalman;
+		benchmark.measure("convert/kalman", 1000, [&](size_t i) {
+			const ofxViveTrackerSample& sample = samples[i % numInputs];
+			const vr::HmdMatrix34_t& mat = sample.pose.mDeviceToAbsoluteTracking;
+			const float* v = sample.pose.vVelocity.v;
+			const float* w = sample.pose.vAngularVelocity.v;
+			kalman.update(samples[0].time + std::chrono::milliseconds(i), ofxViveTrackerMath::toPosition(mat),
+				glm::vec3(v[0], v[1], v[2]), ofxViveTrackerMath::toQuat(mat), glm::vec3(w[0], w[1], w[2]));
+			Benchmark::keep(kalman.getPosition());
+		});
+		return ok;
+	}
+
+	std::shared_ptr<ofxViveTrackerSyntheticSource> makeSource(int devices) {
+		auto source = std::make_shared<ofxViveTrackerSyntheticSource>();
+		source->setNumDevices(devices);
+		source->setStepped(true);
+		return source;
+	}
+
+	// A tracker that disconnects for a while must be recorded as such and
+	// disconnect again when the recording is replayed
+	bool checkRecordReplay(const std::string& path) {
+		const vr::TrackedDeviceIndex_t dropped = 1;
+		auto source = makeSource(3);
+		source->setRate(1000.0f);
+		source->addDisconnect(dropped, 0.1, 0.2);
+		std::string serial = source->getStringProperty(dropped, vr::Prop_SerialNumber_String);
+
+		int liveDisconnected = 0;
+		{
+			ofxViveTracker tracker;
+			tracker.setSource(source);
+			tracker.setMultiTracker(true);
+			if (!tracker.setup() || !tracker.startRecording(path)) {
+				ofLogError("benchmark") << "Record check: setup failed";
+				return false;
+			}
+			for (int i = 0; i < 500; i++) {
+				tracker.update();
+				const ofxViveTrackerDevice* device = tracker.getTrackerBySerial(serial);
+				if (!device || !device->connected) liveDisconnected++;
+			}
+			tracker.close();
+		}
+
+		int recordedDisconnects = 0;
+		{
+			ofxViveTrackerRecording recording;
+			if (!recording.open(path)) {
+				ofLogError("benchmark") << "Record check: can't open " << path;
+				return false;
+			}
+			for (size_t i = 0; i < recording.size(); i++) {
+				if (recording[i].index == dropped && !recording[i].connected) recordedDisconnects++;
+			}
+		}
+
+		int replayDisconnected = 0;
+		int reconnects = 0;
+		{
+			auto replay = std::make_shared<ofxViveTrackerReplaySource>();
+			replay->load(path);
+			replay->setMode(ofxViveTrackerReplaySource::Mode::AsFastAsPossible);
+			ofxViveTracker tracker;
+			tracker.setSource(replay);
+			tracker.setMultiTracker(true);
+			tracker.setup();
+			bool wasConnected = true;
+			for (int i = 0; i < 10000 && !replay->isFinished(); i++) {
+				tracker.update();
+				const ofxViveTrackerDevice* device = tracker.getTrackerBySerial(serial);
+				bool connected = device && device->connected;
+				if (!connected) replayDisconnected++;
+				if (connected && !wasConnected) reconnects++;
+				wasConnected = connected;
+			}
+			tracker.close();
+		}
+		std::remove(path.c_str());
+
+		if (liveDisconnected == 0 || recordedDisconnects == 0 || replayDisconnected == 0 || reconnects != 1) {
+			ofLogError("benchmark") << "Record check: disconnected for " << liveDisconnected << " updates live, "
+				<< recordedDisconnects << " disconnect records, disconnected for " << replayDisconnected
+				<< " updates in replay with " << reconnects << " reconnects";
+			return false;
+		}
+		return true;
+	}
+
+	void benchmarkUpdate(Benchmark& benchmark, int devices, ofxViveTracker::Filter filter, const std::string& name) {
+		ofxViveTracker tracker;
+		tracker.setSource(makeSource(devices));
+		tracker.setMultiTracker(true);
+		tracker.setFilter(filter);
+		tracker.setAutoReconnect(false);
+		if (!tracker.setup() || tracker.getNumTrackers() != size_t(devices)) {
+			ofLogError("benchmark") << name << ": expected " << devices << " trackers, got " << tracker.getNumTrackers();
+			return;
+		}
+
+		for (int i = 0; i < 1000; i++) {
+			tracker.update();
+		}
+		std::vector<double> times;
+		times.reserve(20000);
+		for (int i = 0; i < 20000; i++) {
+			auto start = std::chrono::steady_clock::now();
+			tracker.update();
+			times.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+		}
+		benchmark.addSamples(name, "ns", times);
+		tracker.close();
+	}
+
+	void benchmarkThroughput(Benchmark& benchmark, int devices, bool threaded, double seconds) {
+		std::string name = "throughput/" + std::string(threaded ? "threaded" : "polled") + "/devices=" + ofToString(devices);
+		auto source = makeSource(devices);
+		ofxViveTracker tracker;
+		tracker.setSource(source);
+		tracker.setMultiTracker(true);
+		tracker.setAutoReconnect(false);
+		if (threaded) {
+			// Poll as fast as the source allows, drain at 1 kHz
+			tracker.setThreaded(true, 1e6f, 1 << 16);
+		}
+		if (!tracker.setup()) {
+			ofLogError("benchmark") << name << ": setup failed";
+			return;
+		}
+
+		uint64_t samples = 0;
+		auto start = std::chrono::steady_clock::now();
+		auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+		auto next = start;
+		while (std::chrono::steady_clock::now() < end) {
+			tracker.update();
+			samples += tracker.getSamples().size();
+			if (threaded) {
+				next += std::chrono::milliseconds(1);
+				std::this_thread::sleep_until(next);
+			}
+		}
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		benchmark.addValue(name, "samples/s", samples / elapsed);
+		if (threaded) {
+			benchmark.addValue(name + "/dropped", "samples", double(tracker.getDroppedSamples()));
+		}
+		tracker.close();
+	}
+}
+
+int main(int argc, char** argv) {
+	std::string path = argc > 1 ? argv[1] : ofToDataPath("benchmark.json", true);
+
+	Benchmark benchmark;
+	bool ok = benchmarkConversions(benchmark);
+	if (!checkRecordReplay(ofToDataPath("record-check.bin", true))) {
+		ofLogError("benchmark") << "Record/replay check failed";
+		ok = false;
+	}
+	for (int devices : { 1, 8, 64 }) {
+		benchmarkUpdate(benchmark, devices, ofxViveTracker::Filter::None, "update/devices=" + ofToString(devices));
+	}
+	benchmarkUpdate(benchmark, 64, ofxViveTracker::Filter::OneEuro, "update/oneEuro/devices=64");
+	benchmarkUpdate(benchmark, 64, ofxViveTracker::Filter::Kalman, "update/kalman/devices=64");
+	benchmarkThroughput(benchmark, 8, false, 1.0);
+	benchmarkThroughput(benchmark, 8, true, 1.0);
+	benchmarkThroughput(benchmark, 64, true, 1.0);
+
+	benchmark.log();
+	if (!benchmark.writeJson(path)) {
+		return 1;
+	}
+	ofLogNotice("benchmark") << "Wrote " << path;
+	if (!ok) {
+		ofLogError("benchmark") << "Self-check failed";
+		return 1;
+	}
+	return 0;
+}
@@ -12,6 +12,8 @@ void ofApp::setup() {
 	cam.setFarClip(100.0f);
 	cam.setTarget(glm::vec3(0, -1.0f, 0)); // Orbit around center of box
 
+	// Model and battery for the status text, read in the background
+	tracker.setPropertyCache(true);
 	if (!tracker.setup()) {
 		ofLogError() << "Failed to connect to Vive Tracker";
 	}
@@ -52,6 +54,15 @@ void ofApp::draw() {
 		glm::vec3 pos = tracker.getPosition();
 		ofDrawBitmapString("Position: " + ofToString(pos.x, 3) + ", " + ofToString(pos.y, 3) + ", " + ofToString(pos.z, 3), 20, 50);
 	}
+
+	ofxViveTrackerDeviceProperties properties = tracker.getProperties(0);
+	if (properties.valid) {
+		string info = string(properties.model) + " " + properties.serial;
+		if (properties.hasBattery) {
+			info += "  Battery: " + ofToString(int(properties.batteryLevel * 100.0f)) + "%";
+		}
+		ofDrawBitmapString(info, 20, 70);
+	}
 	ofEnableDepthTest();
 }
 
@@ -167,6 +167,11 @@ void ofApp::setup() {
 	angularVelocityGraph.baseTitle = "Angular Velocity (rad/s)";
 	angularVelocityGraph.scaleMode = ScaleMode::Symmetric;
 
+	// Plot at a steady 250 Hz whatever the frame rate, interpolated from
+	// the last 256 poses
+	tracker.setHistorySize(256);
+	resampler.setup(250.0f);
+
 	if (!tracker.setup()) {
 		ofLogError() << "Failed to connect to Vive Tracker";
 	}
@@ -177,22 +182,20 @@ void ofApp::setup() {
 void ofApp::update() {
 	tracker.update();
 
-	if (!tracker.isTracking()) return;
-
 	int maxSamples = graphWidth;
 
-	glm::vec3 pos = tracker.getPosition();
-	positionGraph.addSample(pos, maxSamples);
+	for (const auto& resampled : resampler.update(tracker)) {
+		if (resampled.slot != 0 || !resampled.pose.tracking) continue;
+		const ofxViveTrackerPose& pose = resampled.pose;
 
-	glm::quat q = tracker.getOrientation();
-	glm::vec3 euler = glm::degrees(glm::eulerAngles(q));
-	orientationGraph.addSample(euler, maxSamples);
+		positionGraph.addSample(pose.position, maxSamples);
 
-	glm::vec3 vel = tracker.getVelocity();
-	velocityGraph.addSample(vel, maxSamples);
+		glm::vec3 euler = glm::degrees(glm::eulerAngles(pose.orientation));
+		orientationGraph.addSample(euler, maxSamples);
 
-	glm::vec3 angVel = tracker.getAngularVelocity();
-	angularVelocityGraph.addSample(angVel, maxSamples);
+		velocityGraph.addSample(pose.velocity, maxSamples);
+		angularVelocityGraph.addSample(pose.angularVelocity, maxSamples);
+	}
 }
 
 void ofApp::draw() {
@@ -2,6 +2,7 @@
 
 #include "ofMain.h"
 #include "ofxViveTracker.h"
+#include "ofxViveTrackerResampler.h"
 #include <deque>
 
 enum class ScaleMode {
@@ -41,6 +42,7 @@ public:
 
 private:
 	ofxViveTracker tracker;
+	ofxViveTrackerResampler resampler;
 
 	Graph positionGraph;
 	Graph orientationGraph;
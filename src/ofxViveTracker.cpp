@@ -1,18 +1,60 @@
 #include "ofxViveTracker.h"
+#include "ofxViveTrackerMath.h"
+#include "ofxViveTrackerOpenVRSource.h"
+
+ofxViveTrackerDevice::ofxViveTrackerDevice()
+	: index(vr::k_unTrackedDeviceIndexInvalid)
+	, connected(false)
+	, poseSample(0) {
+	pose = raw.toPose();
+}
+
+const ofxViveTrackerPose& ofxViveTrackerDevice::getPose() const {
+	if (poseSample != raw.sample) {
+		pose = raw.toPose();
+		poseSample = raw.sample;
+	}
+	return pose;
+}
 
 ofxViveTracker::ofxViveTracker()
-	: vrSystem(nullptr)
-	, trackerIndex(vr::k_unTrackedDeviceIndexInvalid)
+	: sourceConnected(false)
 	, connected(false)
 	, tracking(false)
 	, autoReconnect(true)
+	, multiTracker(false)
+	, threaded(false)
+	, pollRate(1000.0f)
 	, reconnectInterval(2.0f)
-	, lastReconnectAttempt(-10.0f)
-	, position(0.0f)
-	, orientation(1.0f, 0.0f, 0.0f, 0.0f)
-	, matrix(1.0f)
-	, velocity(0.0f)
-	, angularVelocity(0.0f) {
+	, state(State::Disconnected)
+	, sessionActive(false)
+	, connectThreadRunning(false)
+	, connectRequested(false)
+	, connectAttempts(0)
+	, devicesChanged(false)
+	, universeEpoch(0)
+	, poseThreadRunning(false)
+	, trackedMask(0)
+	, droppedSamples(0)
+	, propertyCacheEnabled(false)
+	, propertyRefreshInterval(10.0f)
+	, trackingUniverse(vr::TrackingUniverseStanding)
+	, prediction(Prediction::None)
+	, predictionHorizon(0.0f)
+	, predictionTarget(0)
+	, predictionSeconds(0.0f)
+	, displayFrequency(0.0f)
+	, vsyncToPhotons(0.0f)
+	, filterMode(Filter::None)
+	, filterPending(0) {
+	std::fill(std::begin(deviceClasses), std::end(deviceClasses), vr::TrackedDeviceClass_Invalid);
+	trackers.reserve(vr::k_unMaxTrackedDeviceCount);
+	samples.reserve(vr::k_unMaxTrackedDeviceCount);
+	disconnects.reserve(vr::k_unMaxTrackedDeviceCount);
+	clearTrackers();
+#ifndef OFXVIVETRACKER_NO_OPENVR
+	source = std::make_shared<ofxViveTrackerOpenVRSource>();
+#endif
 }
 
 ofxViveTracker::~ofxViveTracker() {
@@ -20,87 +62,251 @@ ofxViveTracker::~ofxViveTracker() {
 }
 
 bool ofxViveTracker::setup() {
-	lastReconnectAttempt = ofGetElapsedTimef();
-	return tryConnect();
-}
-
-bool ofxViveTracker::tryConnect() {
-	if (vrSystem) {
-		vr::VR_Shutdown();
-		vrSystem = nullptr;
-	}
-	connected = false;
-
-	vr::EVRInitError err = vr::VRInitError_None;
-	vrSystem = vr::VR_Init(&err, vr::VRApplication_Background);
-
-	if (err != vr::VRInitError_None || !vrSystem) {
-		vrSystem = nullptr;
+	if (state == State::Streaming) return true;
+	if (!source) {
+		ofLogError("ofxViveTracker") << "No pose source, call setSource() before setup()";
 		return false;
 	}
 
-	if (!findTracker()) {
-		vr::VR_Shutdown();
-		vrSystem = nullptr;
-		return false;
+	// Wait for one connection attempt so setup() can still report whether a
+	// tracker was found. Retries after that happen in the background.
+	startConnectThread();
+	{
+		std::unique_lock<std::mutex> lock(connectMutex);
+		uint64_t attempts = connectAttempts;
+		if (state == State::Disconnected) {
+			connectRequested = true;
+			connectCondition.notify_all();
+		}
+		connectCondition.wait(lock, [&] {
+			return connectAttempts != attempts || state == State::Discovering || state == State::Streaming;
+		});
 	}
 
-	connected = true;
-	ofLogNotice("ofxViveTracker") << "Connected to tracker at index " << trackerIndex;
-	return true;
+	update();
+	return connected;
 }
 
 void ofxViveTracker::update() {
-	float now = ofGetElapsedTimef();
+	OFXVIVETRACKER_PROFILE(profiler, Update);
+	samples.clear();
+	updateSession();
+	flushDisconnects();
 
-	// Case 1: Not connected to SteamVR at all
-	if (!vrSystem) {
-		if (autoReconnect && (now - lastReconnectAttempt) >= reconnectInterval) {
-			lastReconnectAttempt = now;
-			tryConnect();
+	if (recorder.isOpen() || poseBus.isOpen()) {
+		OFXVIVETRACKER_PROFILE(profiler, Output);
+		if (recorder.isOpen()) {
+			recorder.add(samples);
 		}
+		if (poseBus.isOpen()) {
+			publishPoseBus();
+		}
+	}
+}
+
+void ofxViveTracker::updateSession() {
+	// Case 1: Not connected to SteamVR at all, the connect thread owns the session
+	State current = state.load(std::memory_order_acquire);
+	if (current == State::Disconnected || current == State::Initializing) {
+		connected = false;
 		tracking = false;
 		return;
 	}
 
-	// Poll for VR events to detect SteamVR shutdown
-	vr::VREvent_t event;
-	while (vrSystem->PollNextEvent(&event, sizeof(event))) {
-		if (event.eventType == vr::VREvent_Quit) {
-			ofLogNotice("ofxViveTracker") << "SteamVR is shutting down";
-			vr::VR_Shutdown();
-			vrSystem = nullptr;
-			connected = false;
-			tracking = false;
-			trackerIndex = vr::k_unTrackedDeviceIndexInvalid;
-			return;
+	if (!sessionActive) {
+		beginSession();
+	}
+
+	// Poll for VR events to detect SteamVR shutdown and device changes
+	{
+		OFXVIVETRACKER_PROFILE(profiler, Events);
+		vr::VREvent_t event;
+		while (source->pollNextEvent(event)) {
+			if (event.eventType == vr::VREvent_Quit) {
+				ofLogNotice("ofxViveTracker") << "SteamVR is shutting down";
+				endSession();
+				return;
+			}
+			handleDeviceEvent(event);
 		}
 	}
 
-	// Case 2: Connected to SteamVR but no tracker found
-	if (!connected) {
-		if (autoReconnect && (now - lastReconnectAttempt) >= reconnectInterval) {
-			lastReconnectAttempt = now;
-			if (findTracker()) {
-				connected = true;
-				ofLogNotice("ofxViveTracker") << "Reconnected to tracker at index " << trackerIndex;
+	// Case 2: The device registry changed, pick up new or returning trackers
+	if (devicesChanged) {
+		OFXVIVETRACKER_PROFILE(profiler, Discovery);
+		devicesChanged = false;
+		if (autoReconnect) {
+			bool wasConnected = connected;
+			findTrackers();
+			updateConnectionState();
+			if (!wasConnected && connected) {
+				const ofxViveTrackerDevice& tracker = trackers[getFirstConnectedSlot()];
+				ofLogNotice("ofxViveTracker") << "Reconnected to tracker " << tracker.serial << " at index " << tracker.index;
 			}
 		}
+	}
+
+	// Case 3: Connected to SteamVR but no tracker found
+	if (!connected) {
+		state = State::Discovering;
 		tracking = false;
 		return;
 	}
 
-	updatePose();
+	if (threaded) {
+		drainSamples();
+	} else {
+		updatePose();
+	}
+	state = connected ? State::Streaming : State::Discovering;
 }
 
 void ofxViveTracker::close() {
-	if (vrSystem) {
-		vr::VR_Shutdown();
-		vrSystem = nullptr;
+	stopRecording();
+	stopSharing();
+	stopConnectThread();
+	stopPoseThread();
+	propertyCache.stop();
+	if (sourceConnected) {
+		source->disconnect();
+		sourceConnected = false;
+	}
+	state = State::Disconnected;
+	sessionActive = false;
+	connected = false;
+	tracking = false;
+	clearTrackers();
+}
+
+ofxViveTracker::State ofxViveTracker::getState() const {
+	return state;
+}
+
+void ofxViveTracker::beginSession() {
+	// The connect thread has handed over a fresh session
+	sessionActive = true;
+	devicesChanged = false;
+	startPoseThread();
+	startPropertyCache();
+
+	if (findTrackers()) {
+		updateConnectionState();
+		const ofxViveTrackerDevice& tracker = trackers[getFirstConnectedSlot()];
+		ofLogNotice("ofxViveTracker") << "Connected to tracker " << tracker.serial << " at index " << tracker.index;
+	} else {
+		// Stay connected to SteamVR without a tracker, device events will
+		// report one as soon as it is switched on
+		ofLogNotice("ofxViveTracker") << "Connected to SteamVR, waiting for a tracker";
 	}
+}
+
+void ofxViveTracker::endSession() {
+	// Hand the session back to the connect thread, which shuts it down
+	stopPoseThread();
+	propertyCache.stop();
+	sessionActive = false;
 	connected = false;
 	tracking = false;
-	trackerIndex = vr::k_unTrackedDeviceIndexInvalid;
+	markTrackersDisconnected();
+	{
+		std::lock_guard<std::mutex> lock(connectMutex);
+		state = State::Disconnected;
+	}
+	connectCondition.notify_all();
+}
+
+void ofxViveTracker::startConnectThread() {
+	if (connectThreadRunning) return;
+	connectThreadRunning = true;
+	connectThread = std::thread(&ofxViveTracker::connectThreadFunction, this);
+}
+
+void ofxViveTracker::stopConnectThread() {
+	{
+		std::lock_guard<std::mutex> lock(connectMutex);
+		connectThreadRunning = false;
+	}
+	connectCondition.notify_all();
+	if (connectThread.joinable()) {
+		connectThread.join();
+	}
+}
+
+void ofxViveTracker::connectThreadFunction() {
+	std::minstd_rand random(std::random_device{}());
+	std::uniform_real_distribution<float> jitter(0.5f, 1.0f);
+	int failures = 0;
+	auto nextAttempt = std::chrono::steady_clock::now();
+
+	// The connect thread only touches the source while the state is
+	// Disconnected or Initializing; the update() thread owns it otherwise
+	std::unique_lock<std::mutex> lock(connectMutex);
+	while (connectThreadRunning) {
+		if (state != State::Disconnected) {
+			connectCondition.wait(lock);
+			continue;
+		}
+
+		// A session handed back by endSession()
+		if (sourceConnected) {
+			lock.unlock();
+			source->disconnect();
+			lock.lock();
+			sourceConnected = false;
+			failures = 1;
+			nextAttempt = std::chrono::steady_clock::now() + getBackoff(failures, jitter(random));
+			continue;
+		}
+
+		if (!autoReconnect && !connectRequested) {
+			connectCondition.wait(lock);
+			continue;
+		}
+		if (!connectRequested && std::chrono::steady_clock::now() < nextAttempt) {
+			connectCondition.wait_until(lock, nextAttempt);
+			continue;
+		}
+
+		connectRequested = false;
+		state = State::Initializing;
+		lock.unlock();
+		bool success;
+		{
+			OFXVIVETRACKER_PROFILE(profiler, Connect);
+			success = connectSource();
+		}
+		lock.lock();
+
+		connectAttempts++;
+		if (success) {
+			failures = 0;
+			state.store(State::Discovering, std::memory_order_release);
+		} else {
+			failures++;
+			nextAttempt = std::chrono::steady_clock::now() + getBackoff(failures, jitter(random));
+			state = State::Disconnected;
+		}
+		connectCondition.notify_all();
+	}
+}
+
+std::chrono::steady_clock::duration ofxViveTracker::getBackoff(int failures, float jitter) const {
+	// Exponential backoff from 250ms, capped at reconnectInterval
+	float seconds = 0.25f * std::pow(2.0f, float(std::min(failures - 1, 16)));
+	seconds = std::min(seconds, std::max(reconnectInterval.load(), 0.25f)) * jitter;
+	return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(seconds));
+}
+
+bool ofxViveTracker::connectSource() {
+	if (!source->connect()) {
+		return false;
+	}
+
+	sourceConnected = true;
+	readDisplayTiming();
+	clock.reset();
+	scanDevices();
+	return true;
 }
 
 bool ofxViveTracker::isConnected() const {
@@ -112,91 +318,847 @@ bool ofxViveTracker::isTracking() const {
 }
 
 glm::vec3 ofxViveTracker::getPosition() const {
-	return position;
+	return publishedPoses[0].loadRaw().getPosition();
 }
 
 glm::quat ofxViveTracker::getOrientation() const {
-	return orientation;
+	return getPose().orientation;
 }
 
 glm::mat4 ofxViveTracker::getMatrix() const {
-	return matrix;
+	return getPose().matrix;
 }
 
 glm::vec3 ofxViveTracker::getVelocity() const {
-	return velocity;
+	return publishedPoses[0].loadRaw().velocity;
 }
 
 glm::vec3 ofxViveTracker::getAngularVelocity() const {
-	return angularVelocity;
+	return publishedPoses[0].loadRaw().angularVelocity;
+}
+
+ofxViveTrackerPose ofxViveTracker::getPose() const {
+	return publishedPoses[0].load();
+}
+
+ofxViveTrackerPose ofxViveTracker::getPose(size_t slot) const {
+	if (slot >= vr::k_unMaxTrackedDeviceCount) return ofxViveTrackerPose();
+	return publishedPoses[slot].load();
+}
+
+ofxViveTrackerPose ofxViveTracker::getPredictedPose(size_t slot, std::chrono::steady_clock::time_point time) const {
+	return ofxViveTrackerKalmanFilter::extrapolate(getPose(slot), time);
+}
+
+ofxViveTrackerPose ofxViveTracker::getPoseAt(size_t slot, std::chrono::steady_clock::time_point time, Interpolation interpolation, float maxExtrapolation) const {
+	return history.getPoseAt(slot, time, interpolation, maxExtrapolation);
+}
+
+size_t ofxViveTracker::getNumTrackers() const {
+	return trackers.size();
+}
+
+const ofxViveTrackerDevice& ofxViveTracker::getTracker(size_t slot) const {
+	return trackers[slot];
+}
+
+const ofxViveTrackerDevice* ofxViveTracker::getTrackerByIndex(vr::TrackedDeviceIndex_t index) const {
+	if (index >= vr::k_unMaxTrackedDeviceCount || slotForIndex[index] < 0) return nullptr;
+	return &trackers[slotForIndex[index]];
+}
+
+const ofxViveTrackerDevice* ofxViveTracker::getTrackerBySerial(const std::string& serial) const {
+	auto it = slotForSerial.find(serial);
+	if (it == slotForSerial.end()) return nullptr;
+	return &trackers[it->second];
 }
 
 void ofxViveTracker::setAutoReconnect(bool enable) {
 	autoReconnect = enable;
+	connectCondition.notify_all();
 }
 
 void ofxViveTracker::setReconnectInterval(float seconds) {
 	reconnectInterval = seconds;
 }
 
-bool ofxViveTracker::findTracker() {
+void ofxViveTracker::setSource(std::shared_ptr<ofxViveTrackerSource> s) {
+	close();
+	source = s;
+}
+
+std::shared_ptr<ofxViveTrackerSource> ofxViveTracker::getSource() const {
+	return source;
+}
+
+void ofxViveTracker::setMultiTracker(bool enable) {
+	multiTracker = enable;
+	if (!sessionActive) {
+		// Bound slots depend on the mode
+		clearTrackers();
+	}
+}
+
+void ofxViveTracker::setTrackerSerials(const std::vector<std::string>& serials) {
+	trackerSerials = serials;
+	if (sessionActive) {
+		ofLogWarning("ofxViveTracker") << "setTrackerSerials(): takes effect after close()";
+		return;
+	}
+	// Reserve the bound slots
+	clearTrackers();
+}
+
+const std::vector<std::string>& ofxViveTracker::getTrackerSerials() const {
+	return trackerSerials;
+}
+
+void ofxViveTracker::setThreaded(bool enable, float rate, size_t bufferSize) {
+	bool wasRunning = poseThreadRunning;
+	stopPoseThread();
+
+	threaded = enable;
+	pollRate = std::max(rate, 1.0f);
+	if (threaded) {
+		sampleBuffer.allocate(bufferSize);
+		samples.reserve(sampleBuffer.capacity() + vr::k_unMaxTrackedDeviceCount);
+	}
+
+	if (wasRunning || (threaded && sessionActive)) {
+		startPoseThread();
+	}
+}
+
+void ofxViveTracker::setPrediction(Prediction mode) {
+	prediction = mode;
+}
+
+void ofxViveTracker::setPredictionHorizon(float seconds) {
+	predictionHorizon = seconds;
+	prediction = Prediction::Horizon;
+}
+
+void ofxViveTracker::setPredictionTarget(std::chrono::steady_clock::time_point time) {
+	predictionTarget = time.time_since_epoch().count();
+	prediction = Prediction::Target;
+}
+
+ofxViveTracker::Prediction ofxViveTracker::getPrediction() const {
+	return prediction;
+}
+
+float ofxViveTracker::getPredictionSeconds() const {
+	return predictionSeconds;
+}
+
+void ofxViveTracker::setHistorySize(size_t size) {
+	history.setup(size);
+}
+
+size_t ofxViveTracker::getHistorySize() const {
+	return history.getSize();
+}
+
+const ofxViveTrackerPoseHistory& ofxViveTracker::getHistory() const {
+	return history;
+}
+
+bool ofxViveTracker::startRecording(const std::string& path) {
+	if (!recorder.open(path)) return false;
+	for (const auto& tracker : trackers) {
+		recorder.setSerial(tracker.index, tracker.serial);
+	}
+	return true;
+}
+
+void ofxViveTracker::stopRecording() {
+	recorder.close();
+}
+
+bool ofxViveTracker::isRecording() const {
+	return recorder.isOpen();
+}
+
+void ofxViveTracker::setTrackingUniverse(vr::ETrackingUniverseOrigin origin) {
+	if (trackingUniverse.exchange(origin) != origin) {
+		universeEpoch++;
+		resetFilters();
+		history.clear();
+		// The current poses are in the old universe until the next fetch
+		for (size_t slot = 0; slot < trackers.size(); slot++) {
+			trackers[slot].raw.tracking = false;
+			publishedPoses[slot].store(trackers[slot].raw);
+		}
+	}
+}
+
+vr::ETrackingUniverseOrigin ofxViveTracker::getTrackingUniverse() const {
+	return trackingUniverse;
+}
+
+void ofxViveTracker::setWorldTransform(const glm::mat4& transform) {
+	calibration.setWorldTransform(transform);
+	resetFilters();
+	history.clear();
+}
+
+const glm::mat4& ofxViveTracker::getWorldTransform() const {
+	return calibration.getWorldTransform();
+}
+
+void ofxViveTracker::setLocalOffset(size_t slot, const glm::mat4& offset) {
+	calibration.setLocalOffset(slot, offset);
+	resetFilters();
+	history.clear(slot);
+}
+
+const glm::mat4& ofxViveTracker::getLocalOffset(size_t slot) const {
+	return calibration.getLocalOffset(slot);
+}
+
+void ofxViveTracker::setFilter(Filter mode) {
+	if (mode != filterMode) {
+		resetFilters();
+	}
+	filterMode = mode;
+}
+
+ofxViveTracker::Filter ofxViveTracker::getFilter() const {
+	return filterMode;
+}
+
+ofxViveTrackerOneEuroFilter& ofxViveTracker::getOneEuroFilter() {
+	return filter;
+}
+
+void ofxViveTracker::setKalmanSettings(const ofxViveTrackerKalmanFilter::Settings& settings) {
+	kalmanSettings = settings;
+	for (auto& kalman : kalmanFilters) {
+		kalman.setup(settings);
+	}
+}
+
+const ofxViveTrackerKalmanFilter::Settings& ofxViveTracker::getKalmanSettings() const {
+	return kalmanSettings;
+}
+
+ofxViveTrackerKalmanFilter& ofxViveTracker::getKalmanFilter(size_t slot) {
+	return kalmanFilters[slot];
+}
+
+bool ofxViveTracker::startSharing(const std::string& name, size_t historySize) {
+	if (!poseBus.open(name, historySize)) return false;
+	publishPoseBus();
+	return true;
+}
+
+void ofxViveTracker::stopSharing() {
+	poseBus.close();
+}
+
+bool ofxViveTracker::isSharing() const {
+	return poseBus.isOpen();
+}
+
+void ofxViveTracker::publishPoseBus() {
+	for (size_t slot = 0; slot < trackers.size(); slot++) {
+		const ofxViveTrackerDevice& tracker = trackers[slot];
+		poseBus.setTracker(slot, tracker.index, tracker.serial, tracker.connected);
+	}
+	poseBus.setNumTrackers(trackers.size());
+	for (const ofxViveTrackerSample& sample : samples) {
+		int slot = slotForIndex[sample.index];
+		if (!sample.pose.bDeviceIsConnected) {
+			// By now the slot gave up its index, which may even be taken again
+			for (size_t i = 0; i < trackers.size(); i++) {
+				if (!trackers[i].connected && trackers[i].index == sample.index) slot = (int) i;
+			}
+		}
+		if (slot >= 0) {
+			poseBus.add(slot, sample);
+		}
+	}
+	poseBus.heartbeat();
+}
+
+void ofxViveTracker::setPropertyCache(bool enable, float refreshInterval) {
+	propertyCacheEnabled = enable;
+	propertyRefreshInterval = refreshInterval;
+	propertyCache.stop();
+	startPropertyCache();
+}
+
+ofxViveTrackerDeviceProperties ofxViveTracker::getProperties(size_t slot) const {
+	if (slot >= trackers.size() || !trackers[slot].connected) return ofxViveTrackerDeviceProperties();
+	const ofxViveTrackerDevice& tracker = trackers[slot];
+	ofxViveTrackerDeviceProperties properties = propertyCache.get(tracker.index);
+	// The index may have belonged to another device when it was last read
+	if (tracker.serial != properties.serial) return ofxViveTrackerDeviceProperties();
+	return properties;
+}
+
+const ofxViveTrackerPropertyCache& ofxViveTracker::getPropertyCache() const {
+	return propertyCache;
+}
+
+const ofxViveTrackerClock& ofxViveTracker::getClock() const {
+	return clock;
+}
+
+const std::vector<ofxViveTrackerSample>& ofxViveTracker::getSamples() const {
+	return samples;
+}
+
+ofxViveTrackerProfiler& ofxViveTracker::getProfiler() {
+	return profiler;
+}
+
+uint64_t ofxViveTracker::getDroppedSamples() const {
+	return droppedSamples;
+}
+
+void ofxViveTracker::scanDevices() {
+	// Full scan, only needed once per connection
 	for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
-		if (!vrSystem->IsTrackedDeviceConnected(i)) continue;
-		if (vrSystem->GetTrackedDeviceClass(i) == vr::TrackedDeviceClass_GenericTracker) {
-			trackerIndex = i;
+		refreshDevice(i);
+	}
+	devicesChanged = true;
+}
+
+void ofxViveTracker::refreshDevice(vr::TrackedDeviceIndex_t index) {
+	if (source->isDeviceConnected(index)) {
+		deviceClasses[index] = source->getDeviceClass(index);
+	} else {
+		deviceClasses[index] = vr::TrackedDeviceClass_Invalid;
+	}
+	propertyCache.setDeviceClass(index, deviceClasses[index]);
+	// The only place serials are read, so discovery and update() never query strings
+	if (deviceClasses[index] == vr::TrackedDeviceClass_GenericTracker) {
+		setDeviceSerial(index, source->getStringProperty(index, vr::Prop_SerialNumber_String));
+	} else {
+		setDeviceSerial(index, "");
+	}
+}
+
+void ofxViveTracker::setDeviceSerial(vr::TrackedDeviceIndex_t index, const std::string& serial) {
+	std::string& current = serialForIndex[index];
+	if (current == serial) return;
+	auto it = indexForSerial.find(current);
+	if (it != indexForSerial.end() && it->second == index) {
+		indexForSerial.erase(it);
+	}
+	current = serial;
+	if (!serial.empty()) {
+		indexForSerial[serial] = index;
+	}
+}
+
+void ofxViveTracker::handleDeviceEvent(const vr::VREvent_t& event) {
+	vr::TrackedDeviceIndex_t index = event.trackedDeviceIndex;
+	bool valid = index < vr::k_unMaxTrackedDeviceCount;
+
+	switch (event.eventType) {
+	case vr::VREvent_TrackedDeviceActivated:
+	case vr::VREvent_TrackedDeviceUpdated:
+	case vr::VREvent_TrackedDeviceRoleChanged:
+		if (valid) {
+			refreshDevice(index);
+		} else {
+			scanDevices();
+		}
+		devicesChanged = true;
+		break;
+	case vr::VREvent_TrackedDeviceDeactivated:
+		if (valid) {
+			deviceClasses[index] = vr::TrackedDeviceClass_Invalid;
+			setDeviceSerial(index, "");
+			propertyCache.setDeviceClass(index, vr::TrackedDeviceClass_Invalid);
+			if (slotForIndex[index] >= 0) {
+				disconnectTracker(slotForIndex[index]);
+				updateConnectionState();
+			}
+		}
+		devicesChanged = true;
+		break;
+	case vr::VREvent_PropertyChanged:
+		// Read again by the property cache, if it runs
+		if (valid) {
+			propertyCache.invalidate(index);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+bool ofxViveTracker::findTrackers() {
+	bool found = false;
+	if (multiTracker) {
+		for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+			if (deviceClasses[i] != vr::TrackedDeviceClass_GenericTracker) continue;
+			addTracker(i);
+			found = true;
+		}
+	} else {
+		found = findSingleTracker();
+	}
+	publishTrackedMask();
+	return found;
+}
+
+bool ofxViveTracker::findSingleTracker() {
+	// Keep the current tracker while it is connected
+	if (!trackers.empty() && trackers[0].connected) {
+		return true;
+	}
+
+	// Then the bound or previous tracker, wherever it is now
+	if (!trackers.empty() && !trackers[0].serial.empty()) {
+		auto it = indexForSerial.find(trackers[0].serial);
+		if (it != indexForSerial.end()) {
+			addTracker(it->second);
 			return true;
 		}
+		// A bound slot waits for its own tracker
+		if (!trackerSerials.empty()) return false;
+	}
+
+	for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+		if (deviceClasses[i] != vr::TrackedDeviceClass_GenericTracker) continue;
+
+		// The table only ever holds one tracker, and the previous one is gone
+		if (!trackers.empty()) {
+			clearTrackers();
+		}
+		addTracker(i);
+		return true;
 	}
 	return false;
 }
 
+void ofxViveTracker::addTracker(vr::TrackedDeviceIndex_t index) {
+	if (slotForIndex[index] >= 0) {
+		trackers[slotForIndex[index]].connected = true;
+		return;
+	}
+
+	// A tracker we have seen before may come back at a different index
+	const std::string& serial = serialForIndex[index];
+	auto it = serial.empty() ? slotForSerial.end() : slotForSerial.find(serial);
+	size_t slot;
+	if (it != slotForSerial.end()) {
+		slot = it->second;
+	} else {
+		if (trackers.size() >= vr::k_unMaxTrackedDeviceCount) return;
+		slot = trackers.size();
+		trackers.emplace_back();
+		trackers[slot].serial = serial;
+		if (!serial.empty()) slotForSerial[serial] = slot;
+	}
+
+	ofxViveTrackerDevice& tracker = trackers[slot];
+	tracker.index = index;
+	tracker.connected = true;
+	slotForIndex[index] = (int)slot;
+	recorder.setSerial(index, tracker.serial);
+}
+
+void ofxViveTracker::disconnectTracker(size_t slot, bool haveSample) {
+	ofxViveTrackerDevice& tracker = trackers[slot];
+	if (!tracker.connected) return;
+
+	ofLogWarning("ofxViveTracker") << "Tracker " << tracker.serial << " disconnected";
+	if (!haveSample) {
+		addDisconnect(slot);
+	}
+	tracker.connected = false;
+	tracker.raw.tracking = false;
+	tracker.raw.sample++;
+	slotForIndex[tracker.index] = -1;
+	filter.reset(slot);
+	kalmanFilters[slot].reset();
+	publishedPoses[slot].store(tracker.raw);
+	publishTrackedMask();
+}
+
+void ofxViveTracker::clearTrackers() {
+	trackers.clear();
+	slotForSerial.clear();
+	size_t bound = multiTracker ? trackerSerials.size() : std::min<size_t>(trackerSerials.size(), 1);
+	for (size_t slot = 0; slot < bound && slot < vr::k_unMaxTrackedDeviceCount; slot++) {
+		trackers.emplace_back();
+		trackers[slot].serial = trackerSerials[slot];
+		slotForSerial.emplace(trackerSerials[slot], slot);
+	}
+	std::fill(std::begin(slotForIndex), std::end(slotForIndex), -1);
+	for (auto& published : publishedPoses) {
+		published.store(ofxViveTrackerRawPose());
+	}
+	history.clear();
+	resetFilters();
+	publishTrackedMask();
+}
+
+void ofxViveTracker::addDisconnect(size_t slot) {
+	const ofxViveTrackerDevice& tracker = trackers[slot];
+	ofxViveTrackerSample sample;
+	memset(&sample.pose, 0, sizeof(sample.pose));
+	sample.pose.eTrackingResult = vr::TrackingResult_Uninitialized;
+	sample.frame = tracker.raw.frame;
+	sample.index = tracker.index;
+	disconnects.push_back(sample);
+}
+
+void ofxViveTracker::flushDisconnects() {
+	if (disconnects.empty()) return;
+	// After every pose of this update, so a replay doesn't connect them again
+	auto time = std::chrono::steady_clock::now();
+	if (!samples.empty()) {
+		time = std::max(time, samples.back().time);
+	}
+	for (ofxViveTrackerSample& sample : disconnects) {
+		sample.time = time;
+		samples.push_back(sample);
+	}
+	disconnects.clear();
+}
+
+void ofxViveTracker::markTrackersDisconnected() {
+	for (size_t slot = 0; slot < trackers.size(); slot++) {
+		if (trackers[slot].connected) {
+			addDisconnect(slot);
+		}
+		trackers[slot].connected = false;
+		trackers[slot].raw.tracking = false;
+		trackers[slot].raw.sample++;
+		publishedPoses[slot].store(trackers[slot].raw);
+	}
+	std::fill(std::begin(slotForIndex), std::end(slotForIndex), -1);
+	resetFilters();
+	publishTrackedMask();
+}
+
+size_t ofxViveTracker::getFirstConnectedSlot() const {
+	for (size_t slot = 0; slot < trackers.size(); slot++) {
+		if (trackers[slot].connected) return slot;
+	}
+	return 0;
+}
+
+void ofxViveTracker::publishTrackedMask() {
+	uint64_t mask = 0;
+	for (const auto& tracker : trackers) {
+		if (tracker.connected) mask |= uint64_t(1) << tracker.index;
+	}
+	trackedMask.store(mask, std::memory_order_relaxed);
+}
+
+void ofxViveTracker::startPropertyCache() {
+	if (!propertyCacheEnabled || !sessionActive) return;
+	propertyCache.start(source, propertyRefreshInterval);
+}
+
+void ofxViveTracker::startPoseThread() {
+	if (!threaded || !sessionActive || poseThreadRunning) return;
+	poseThreadRunning = true;
+	poseThread = std::thread(&ofxViveTracker::poseThreadFunction, this);
+}
+
+void ofxViveTracker::stopPoseThread() {
+	poseThreadRunning = false;
+	if (poseThread.joinable()) {
+		poseThread.join();
+	}
+}
+
+void ofxViveTracker::poseThreadFunction() {
+	auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / pollRate));
+	auto next = std::chrono::steady_clock::now();
+	vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+
+	while (poseThreadRunning) {
+		std::chrono::steady_clock::time_point time;
+		uint64_t frame;
+		// Read before the fetch reads the universe, so a change in between
+		// only costs this fetch
+		uint64_t epoch = universeEpoch;
+		fetchPoses(poses, time, frame);
+
+		uint64_t mask = trackedMask.load(std::memory_order_relaxed);
+		for (vr::TrackedDeviceIndex_t i = 0; mask; i++, mask >>= 1) {
+			if (!(mask & 1)) continue;
+			PolledSample polled;
+			polled.sample.time = time;
+			polled.sample.frame = frame;
+			polled.sample.index = i;
+			polled.sample.pose = poses[i];
+			polled.universeEpoch = epoch;
+			if (!sampleBuffer.push(polled)) {
+				droppedSamples++;
+			}
+		}
+
+		// Don't try to catch up after a stall, just resume the schedule
+		auto now = std::chrono::steady_clock::now();
+		next += period;
+		if (next < now) next = now;
+		std::this_thread::sleep_until(next);
+	}
+}
+
+void ofxViveTracker::readDisplayTiming() {
+	// Properties of the headset, if there is one. Read once per connection
+	// so the per-frame prediction doesn't cost any property round trips.
+	if (!source->getFloatProperty(vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_DisplayFrequency_Float, displayFrequency)) {
+		displayFrequency = 0.0f;
+	}
+	if (!source->getFloatProperty(vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_SecondsFromVsyncToPhotons_Float, vsyncToPhotons)) {
+		vsyncToPhotons = 0.0f;
+	}
+}
+
+float ofxViveTracker::computePredictionSeconds(std::chrono::steady_clock::time_point now, bool haveVsync, float secondsSinceVsync) {
+	float seconds = 0.0f;
+	switch (prediction.load()) {
+	case Prediction::None:
+		break;
+	case Prediction::Horizon:
+		seconds = predictionHorizon;
+		break;
+	case Prediction::Target: {
+		std::chrono::steady_clock::duration ahead(predictionTarget.load() - now.time_since_epoch().count());
+		seconds = std::chrono::duration<float>(ahead).count();
+		break;
+	}
+	case Prediction::Vsync: {
+		// Same horizon the compositor uses: the rest of this frame plus
+		// the display's vsync to photons latency
+		if (displayFrequency > 0.0f && haveVsync) {
+			seconds = 1.0f / displayFrequency - secondsSinceVsync;
+		}
+		seconds += vsyncToPhotons;
+		break;
+	}
+	}
+	predictionSeconds = seconds;
+	return seconds;
+}
+
+void ofxViveTracker::fetchPoses(vr::TrackedDevicePose_t* poses, std::chrono::steady_clock::time_point& time, uint64_t& frame) {
+	OFXVIVETRACKER_PROFILE(profiler, Fetch);
+	float secondsSinceVsync = 0.0f;
+	frame = 0;
+	bool haveVsync = source->getTimeSinceLastVsync(secondsSinceVsync, frame);
+	auto now = std::chrono::steady_clock::now();
+	if (haveVsync) {
+		clock.addObservation(now, secondsSinceVsync, frame);
+	}
+
+	float seconds = computePredictionSeconds(now, haveVsync, secondsSinceVsync);
+	source->getPoses(trackingUniverse.load(), seconds, poses, vr::k_unMaxTrackedDeviceCount);
+	// A shared snapshot was fetched before this call
+	source->getPosesFetchTime(now);
+	time = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(seconds));
+}
+
 void ofxViveTracker::updatePose() {
 	vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
-	vrSystem->GetDeviceToAbsoluteTrackingPose(vr::TrackingUniverseStanding, 0.0f, poses, vr::k_unMaxTrackedDeviceCount);
+	std::chrono::steady_clock::time_point time;
+	uint64_t frame;
+	fetchPoses(poses, time, frame);
 
-	const vr::TrackedDevicePose_t& p = poses[trackerIndex];
+	{
+		OFXVIVETRACKER_PROFILE(profiler, Convert);
+		for (size_t slot = 0; slot < trackers.size(); slot++) {
+			if (!trackers[slot].connected) continue;
 
-	// Check if device disconnected
-	if (!p.bDeviceIsConnected) {
-		ofLogWarning("ofxViveTracker") << "Tracker disconnected";
-		connected = false;
-		tracking = false;
-		trackerIndex = vr::k_unTrackedDeviceIndexInvalid;
-		return;
+			ofxViveTrackerSample sample;
+			sample.time = time;
+			sample.frame = frame;
+			sample.index = trackers[slot].index;
+			sample.pose = poses[sample.index];
+			samples.push_back(sample);
+		}
+
+		calibratePoses(poses);
+		if (filterMode != Filter::None) {
+			converted.convert(poses, getConvertCount(), false);
+		}
+		for (size_t slot = 0; slot < trackers.size(); slot++) {
+			if (!trackers[slot].connected) continue;
+			applyPose(slot, poses[trackers[slot].index], time, frame);
+		}
+	}
+
+	filterPoses();
+	updateConnectionState();
+}
+
+void ofxViveTracker::drainSamples() {
+	// Only drain what is there now, the worker keeps pushing meanwhile
+	size_t count = sampleBuffer.size();
+	const ofxViveTrackerSample* latest[vr::k_unMaxTrackedDeviceCount] = {};
+
+	{
+		OFXVIVETRACKER_PROFILE(profiler, Drain);
+		uint64_t epoch = universeEpoch;
+		PolledSample polled;
+		for (size_t i = 0; i < count && sampleBuffer.pop(polled); i++) {
+			const ofxViveTrackerSample& sample = polled.sample;
+			// Fetched in another universe, or before an event dropped the tracker
+			if (polled.universeEpoch != epoch || slotForIndex[sample.index] < 0) continue;
+			samples.push_back(sample);
+			latest[sample.index] = &samples.back();
+		}
+	}
+
+	// The Kalman filter and the history want every sample, applyPose()
+	// handles the newest
+	if (filterMode == Filter::Kalman || (filterMode == Filter::None && history.getSize())) {
+		OFXVIVETRACKER_PROFILE(profiler, Filter);
+		for (const auto& s : samples) {
+			int slot = slotForIndex[s.index];
+			if (slot < 0 || &s == latest[s.index]) continue;
+			addSample(slot, s);
+		}
+	}
+
+	// Only the newest sample per tracker needs converting for the getters
+	{
+		OFXVIVETRACKER_PROFILE(profiler, Convert);
+		vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+		const vr::TrackedDevicePose_t none = {};
+		size_t count = getConvertCount();
+		for (size_t i = 0; i < count; i++) {
+			poses[i] = latest[i] ? latest[i]->pose : none;
+		}
+		calibratePoses(poses);
+		if (filterMode != Filter::None) {
+			converted.convert(poses, count, false);
+		}
+		for (size_t slot = 0; slot < trackers.size(); slot++) {
+			const ofxViveTrackerDevice& tracker = trackers[slot];
+			if (!tracker.connected || !latest[tracker.index]) continue;
+			const ofxViveTrackerSample& sample = *latest[tracker.index];
+			applyPose(slot, poses[tracker.index], sample.time, sample.frame);
+		}
+	}
+
+	filterPoses();
+	updateConnectionState();
+}
+
+size_t ofxViveTracker::getConvertCount() const {
+	// Only devices up to the highest connected tracker index
+	size_t count = 0;
+	for (const auto& tracker : trackers) {
+		if (tracker.connected) count = std::max<size_t>(count, tracker.index + 1);
+	}
+	return count;
+}
+
+void ofxViveTracker::calibratePoses(vr::TrackedDevicePose_t* poses) const {
+	if (calibration.isIdentity()) return;
+	for (size_t slot = 0; slot < trackers.size(); slot++) {
+		if (trackers[slot].connected) {
+			calibration.apply(slot, poses[trackers[slot].index]);
+		}
 	}
+}
 
-	tracking = p.bPoseIsValid;
+void ofxViveTracker::applyPose(size_t slot, const vr::TrackedDevicePose_t& p, std::chrono::steady_clock::time_point time, uint64_t frame) {
+	ofxViveTrackerDevice& tracker = trackers[slot];
+	ofxViveTrackerRawPose& raw = tracker.raw;
+	raw.time = time;
+	raw.frame = frame;
+	raw.sample++;
+	raw.trackingResult = p.eTrackingResult;
 
-	if (!tracking) {
+	// Check if device disconnected
+	if (!p.bDeviceIsConnected) {
+		deviceClasses[tracker.index] = vr::TrackedDeviceClass_Invalid;
+		disconnectTracker(slot, true);
 		return;
 	}
 
-	matrix = convertMatrix(p.mDeviceToAbsoluteTracking);
+	raw.tracking = p.bPoseIsValid;
+	if (raw.tracking) {
+		updateDevice(raw, p);
+		if (filterMode == Filter::Kalman) {
+			ofxViveTrackerKalmanFilter& kalman = kalmanFilters[slot];
+			kalman.update(time, converted.getPosition(tracker.index), raw.velocity, converted.getOrientation(tracker.index), raw.angularVelocity);
+			kalman.getEstimate(raw);
+		} else if (filterMode == Filter::OneEuro) {
+			// Published by filterPoses() once every tracker is in
+			filter.setInput(slot, converted.getPosition(tracker.index), converted.getOrientation(tracker.index), time);
+			filterPending |= uint64_t(1) << slot;
+			return;
+		}
+		history.add(slot, raw);
+	}
+	publishedPoses[slot].store(raw);
+}
 
-	position.x = p.mDeviceToAbsoluteTracking.m[0][3];
-	position.y = p.mDeviceToAbsoluteTracking.m[1][3];
-	position.z = p.mDeviceToAbsoluteTracking.m[2][3];
+void ofxViveTracker::filterPoses() {
+	if (!filterPending) return;
+	OFXVIVETRACKER_PROFILE(profiler, Filter);
+	filter.apply(trackers.size());
+	for (size_t slot = 0; slot < trackers.size(); slot++) {
+		if (!(filterPending & (uint64_t(1) << slot))) continue;
+		ofxViveTrackerRawPose& raw = trackers[slot].raw;
+		ofxViveTrackerMath::toMatrix(filter.getOrientation(slot), filter.getPosition(slot), raw.matrix);
+		history.add(slot, raw);
+		publishedPoses[slot].store(raw);
+	}
+	filterPending = 0;
+}
 
-	orientation = matrixToQuat(matrix);
+void ofxViveTracker::resetFilters() {
+	filter.reset();
+	filterPending = 0;
+	for (auto& kalman : kalmanFilters) {
+		kalman.reset();
+	}
+}
 
-	velocity.x = p.vVelocity.v[0];
-	velocity.y = p.vVelocity.v[1];
-	velocity.z = p.vVelocity.v[2];
+void ofxViveTracker::addSample(size_t slot, const ofxViveTrackerSample& sample) {
+	vr::TrackedDevicePose_t p = sample.pose;
+	if (!p.bDeviceIsConnected || !p.bPoseIsValid) return;
+	calibration.apply(slot, p);
 
-	angularVelocity.x = p.vAngularVelocity.v[0];
-	angularVelocity.y = p.vAngularVelocity.v[1];
-	angularVelocity.z = p.vAngularVelocity.v[2];
+	ofxViveTrackerRawPose raw;
+	raw.tracking = true;
+	raw.trackingResult = p.eTrackingResult;
+	raw.time = sample.time;
+	raw.frame = sample.frame;
+	updateDevice(raw, p);
+	if (filterMode == Filter::Kalman) {
+		ofxViveTrackerKalmanFilter& kalman = kalmanFilters[slot];
+		kalman.update(sample.time, raw.getPosition(), raw.velocity, ofxViveTrackerMath::toQuat(raw.matrix), raw.angularVelocity);
+		kalman.getEstimate(raw);
+	}
+	history.add(slot, raw);
 }
 
-glm::mat4 ofxViveTracker::convertMatrix(const vr::HmdMatrix34_t& mat) {
-	return glm::mat4(
-		mat.m[0][0], mat.m[1][0], mat.m[2][0], 0.0f,
-		mat.m[0][1], mat.m[1][1], mat.m[2][1], 0.0f,
-		mat.m[0][2], mat.m[1][2], mat.m[2][2], 0.0f,
-		mat.m[0][3], mat.m[1][3], mat.m[2][3], 1.0f
-	);
+void ofxViveTracker::updateConnectionState() {
+	connected = false;
+	for (const auto& tracker : trackers) {
+		connected = connected || tracker.connected;
+	}
+	tracking = !trackers.empty() && trackers[0].raw.tracking;
 }
 
-glm::quat ofxViveTracker::matrixToQuat(const glm::mat4& mat) {
-	return glm::quat_cast(mat);
+void ofxViveTracker::updateDevice(ofxViveTrackerRawPose& pose, const vr::TrackedDevicePose_t& p) {
+	// Orientation and mat4 are only derived when someone asks for them
+	pose.matrix = p.mDeviceToAbsoluteTracking;
+
+	pose.velocity.x = p.vVelocity.v[0];
+	pose.velocity.y = p.vVelocity.v[1];
+	pose.velocity.z = p.vVelocity.v[2];
+
+	pose.angularVelocity.x = p.vAngularVelocity.v[0];
+	pose.angularVelocity.y = p.vAngularVelocity.v[1];
+	pose.angularVelocity.z = p.vAngularVelocity.v[2];
+
+	pose.acceleration = glm::vec3(0.0f);
 }
@@ -2,22 +2,200 @@
 
 #include "ofMain.h"
 #include <openvr.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
+#include "ofxViveTrackerCalibration.h"
+#include "ofxViveTrackerClock.h"
+#include "ofxViveTrackerKalmanFilter.h"
+#include "ofxViveTrackerOneEuroFilter.h"
+#include "ofxViveTrackerPose.h"
+#include "ofxViveTrackerPoseBatch.h"
+#include "ofxViveTrackerPoseBus.h"
+#include "ofxViveTrackerPoseHistory.h"
+#include "ofxViveTrackerProfiler.h"
+#include "ofxViveTrackerPropertyCache.h"
+#include "ofxViveTrackerPublishedPose.h"
+#include "ofxViveTrackerRecorder.h"
+#include "ofxViveTrackerRingBuffer.h"
+#include "ofxViveTrackerSeqLock.h"
+#include "ofxViveTrackerSource.h"
+
+struct ofxViveTrackerDevice {
+	vr::TrackedDeviceIndex_t index;
+	std::string serial;
+
+	bool connected;
+
+	// Last pose seen by update(), as OpenVR reported it or as filtered.
+	// Only safe to read on the thread calling update(); other threads
+	// should use ofxViveTracker::getPose().
+	ofxViveTrackerRawPose raw;
+
+	ofxViveTrackerDevice();
+
+	// raw plus orientation and mat4, derived on first access per sample.
+	const ofxViveTrackerPose& getPose() const;
+
+private:
+	mutable ofxViveTrackerPose pose;
+	mutable uint64_t poseSample;
+};
 
 class ofxViveTracker {
 public:
+	enum class State {
+		Disconnected, // No SteamVR session, waiting to retry
+		Initializing, // Source connecting (VR_Init) on the connect thread
+		Discovering,  // Connected to SteamVR, no tracker yet
+		Streaming     // At least one tracker connected
+	};
+
+	enum class Prediction {
+		None,    // Pose at the time of the call (default)
+		Horizon, // Fixed number of seconds ahead, see setPredictionHorizon()
+		Target,  // A given steady_clock instant, see setPredictionTarget()
+		Vsync    // When the next frame reaches the display, from the vsync timing
+	};
+
+	enum class Filter {
+		None,    // Poses as OpenVR reports them (default)
+		OneEuro, // Adaptive low-pass on position and orientation
+		Kalman   // Kalman filter fusing pose, velocity and angular velocity
+	};
+
+	using Interpolation = ofxViveTrackerPoseHistory::Interpolation;
+
 	ofxViveTracker();
 	~ofxViveTracker();
 
+	// Connecting happens on a background thread. setup() waits for the first
+	// attempt only; update() never blocks and just follows the state.
 	bool setup();
 	void update();
 	void close();
 
 	bool isConnected() const;
 	bool isTracking() const;
+	State getState() const;
 
 	void setAutoReconnect(bool enable);
+	// Longest wait between connection attempts. Retries back off
+	// exponentially from 250ms up to this, with random jitter.
 	void setReconnectInterval(float seconds);
 
+	// Where devices and poses come from. Defaults to OpenVR, with one
+	// session shared by every instance in the process; use
+	// ofxViveTrackerSyntheticSource or ofxViveTrackerReplaySource to run
+	// without a headset. Closes any current session.
+	void setSource(std::shared_ptr<ofxViveTrackerSource> source);
+	std::shared_ptr<ofxViveTrackerSource> getSource() const;
+
+	// Track every GenericTracker instead of only the first one found.
+	// Call before setup(). The getters below then refer to the first tracker.
+	void setMultiTracker(bool enable);
+
+	// Bind trackers to slots by Prop_SerialNumber_String: serials[i] always
+	// gets slot i, whatever index OpenVR gives it and in whatever order the
+	// trackers are switched on. Bound slots exist from the start and stay
+	// disconnected until their tracker shows up; unbound trackers get the
+	// slots after them. In single-tracker mode only serials[0] is used and
+	// no other tracker is ever taken in its place. Without a binding the
+	// single tracker mode prefers the tracker it had before a dropout and
+	// otherwise takes the first one found. Call before setup().
+	void setTrackerSerials(const std::vector<std::string>& serials);
+	const std::vector<std::string>& getTrackerSerials() const;
+
+	// Poll poses on a worker thread at pollRate Hz instead of once per
+	// update(). update() then drains everything the worker produced since
+	// the previous call without blocking, so render hitches lose no samples.
+	void setThreaded(bool enable, float pollRate = 1000.0f, size_t bufferSize = 16384);
+
+	// Pose prediction. All modes pass the horizon to OpenVR as
+	// fPredictedSecondsToPhotonsFromNow, which extrapolates using the
+	// tracker's own velocity and angular velocity.
+	void setPrediction(Prediction mode);
+	void setPredictionHorizon(float seconds);
+	void setPredictionTarget(std::chrono::steady_clock::time_point time);
+	Prediction getPrediction() const;
+	// Horizon used for the most recent pose fetch.
+	float getPredictionSeconds() const;
+
+	// Tracking universe poses are fetched in, TrackingUniverseStanding by
+	// default. Changing it resets the filters and the history, and poses
+	// read as not tracking until the first fetch in the new universe.
+	void setTrackingUniverse(vr::ETrackingUniverseOrigin origin);
+	vr::ETrackingUniverseOrigin getTrackingUniverse() const;
+
+	// Calibration folded into the pose conversion, so getters, filters and
+	// broadcasts are all in world space: world * pose * local offset of the
+	// slot. getSamples(), recordings and the pose bus stay as the source
+	// reported them. Call from the update() thread; changes reset the
+	// filters. See ofxViveTrackerCalibration.
+	void setWorldTransform(const glm::mat4& transform);
+	const glm::mat4& getWorldTransform() const;
+	void setLocalOffset(size_t slot, const glm::mat4& offset);
+	const glm::mat4& getLocalOffset(size_t slot) const;
+
+	// Smooth poses before they reach the getters. Raw poses stay available
+	// through getSamples(). One Euro parameters can be set per slot through
+	// getOneEuroFilter(). The Kalman filter fuses every sample, also those
+	// drained in threaded mode.
+	void setFilter(Filter mode);
+	Filter getFilter() const;
+	ofxViveTrackerOneEuroFilter& getOneEuroFilter();
+	void setKalmanSettings(const ofxViveTrackerKalmanFilter::Settings& settings);
+	const ofxViveTrackerKalmanFilter::Settings& getKalmanSettings() const;
+	ofxViveTrackerKalmanFilter& getKalmanFilter(size_t slot);
+
+	// Keep the last size poses of every tracker for getPoseAt(), as the
+	// getters saw them plus, in threaded mode, the samples in between
+	// (except with the One Euro filter). 0, the default, keeps none. Call
+	// before setup(), or at least while no other thread calls getPoseAt().
+	void setHistorySize(size_t size);
+	size_t getHistorySize() const;
+	const ofxViveTrackerPoseHistory& getHistory() const;
+
+	// Append every sample to a binary file as update() sees it. Read it
+	// back with ofxViveTrackerRecording or play it with the replay source.
+	bool startRecording(const std::string& path);
+	void stopRecording();
+	bool isRecording() const;
+
+	// Publish the pose table and every sample to named shared memory, for
+	// other processes on this machine to read with
+	// ofxViveTrackerPoseBusReader. historySize poses are kept per tracker.
+	bool startSharing(const std::string& name = "ofxViveTracker", size_t historySize = 256);
+	void stopSharing();
+	bool isSharing() const;
+
+	// Read battery level, model and the other ofxViveTrackerDeviceProperties
+	// of every device on a background thread, one device at a time. Events
+	// that change a device have it read again right away, and each device
+	// is refreshed every refreshInterval seconds. Off by default.
+	void setPropertyCache(bool enable, float refreshInterval = 10.0f);
+	// Properties of a slot's tracker as last read, from the update() thread.
+	// getPropertyCache().get(index) is lock-free and safe from any thread.
+	ofxViveTrackerDeviceProperties getProperties(size_t slot) const;
+	const ofxViveTrackerPropertyCache& getPropertyCache() const;
+
+	// Maps pose timestamps to and from the OpenVR frame counter.
+	const ofxViveTrackerClock& getClock() const;
+
+	// Raw samples taken during the last update(), oldest first: one per
+	// connected tracker normally, everything the worker produced in
+	// threaded mode.
+	const std::vector<ofxViveTrackerSample>& getSamples() const;
+	// Threaded mode: samples lost because update() fell behind the worker.
+	uint64_t getDroppedSamples() const;
+
+	// Time spent in each stage of update(), the pose thread and connection
+	// attempts, e.g. getProfiler().getReport(). Empty when built with
+	// OFXVIVETRACKER_NO_PROFILING.
+	ofxViveTrackerProfiler& getProfiler();
+
 	glm::vec3 getPosition() const;
 	glm::quat getOrientation() const;
 	glm::mat4 getMatrix() const;
@@ -25,26 +203,149 @@ public:
 	glm::vec3 getVelocity() const;
 	glm::vec3 getAngularVelocity() const;
 
+	// Consistent snapshot of the first tracker's pose. Safe to call from any
+	// thread: it never blocks and never returns fields from different samples.
+	ofxViveTrackerPose getPose() const;
+	ofxViveTrackerPose getPose(size_t slot) const;
+	// Latest pose of a slot extrapolated to time from its velocity and
+	// angular velocity, plus acceleration with the constant acceleration
+	// Kalman model. Safe to call from any thread.
+	ofxViveTrackerPose getPredictedPose(size_t slot, std::chrono::steady_clock::time_point time) const;
+	// Pose of a slot at time from the history (see setHistorySize()),
+	// interpolated between the poses around it or extrapolated up to
+	// maxExtrapolation seconds past the newest. Safe to call from any thread.
+	ofxViveTrackerPose getPoseAt(size_t slot, std::chrono::steady_clock::time_point time, Interpolation interpolation = Interpolation::Linear, float maxExtrapolation = 0.05f) const;
+
+	// Pose table. Slots are stable for the lifetime of the connection: a
+	// tracker that drops out keeps its slot and gets it back on reconnect.
+	// The table itself only changes inside update().
+	size_t getNumTrackers() const;
+	const ofxViveTrackerDevice& getTracker(size_t slot) const;
+	const ofxViveTrackerDevice* getTrackerByIndex(vr::TrackedDeviceIndex_t index) const;
+	const ofxViveTrackerDevice* getTrackerBySerial(const std::string& serial) const;
+
 private:
-	vr::IVRSystem* vrSystem;
-	vr::TrackedDeviceIndex_t trackerIndex;
+	std::shared_ptr<ofxViveTrackerSource> source;
+	bool sourceConnected;
 	vr::TrackedDevicePose_t pose;
 
 	bool connected;
 	bool tracking;
-	bool autoReconnect;
-	float reconnectInterval;
-	float lastReconnectAttempt;
-
-	glm::vec3 position;
-	glm::quat orientation;
-	glm::mat4 matrix;
-	glm::vec3 velocity;
-	glm::vec3 angularVelocity;
-
-	bool findTracker();
-	bool tryConnect();
+	std::atomic<bool> autoReconnect;
+	bool multiTracker;
+	bool threaded;
+	float pollRate;
+	std::atomic<float> reconnectInterval;
+
+	std::atomic<State> state;
+	bool sessionActive;
+	std::thread connectThread;
+	std::mutex connectMutex;
+	std::condition_variable connectCondition;
+	bool connectThreadRunning;
+	bool connectRequested;
+	uint64_t connectAttempts;
+
+	// Device class of every slot, kept current from device events so that
+	// discovery needs no IPC while connected
+	vr::ETrackedDeviceClass deviceClasses[vr::k_unMaxTrackedDeviceCount];
+	bool devicesChanged;
+	// Serial of every connected tracker and the reverse, read once when the
+	// device is activated and dropped when it is deactivated
+	std::string serialForIndex[vr::k_unMaxTrackedDeviceCount];
+	std::unordered_map<std::string, vr::TrackedDeviceIndex_t> indexForSerial;
+	std::vector<std::string> trackerSerials;
+
+	std::vector<ofxViveTrackerDevice> trackers;
+	int slotForIndex[vr::k_unMaxTrackedDeviceCount];
+	std::unordered_map<std::string, size_t> slotForSerial;
+	ofxViveTrackerPublishedPose publishedPoses[vr::k_unMaxTrackedDeviceCount];
+
+	// Samples from the pose thread, tagged with the universe epoch they
+	// were fetched in
+	struct PolledSample {
+		ofxViveTrackerSample sample;
+		uint64_t universeEpoch;
+	};
+	ofxViveTrackerRingBuffer<PolledSample> sampleBuffer;
+	// Bumped by setTrackingUniverse() after the change, so drainSamples()
+	// drops what was fetched in the old universe
+	std::atomic<uint64_t> universeEpoch;
+	std::vector<ofxViveTrackerSample> samples;
+	// Trackers dropped by events during this update(), added to samples
+	// after the poses so recordings and the pose bus see them go
+	std::vector<ofxViveTrackerSample> disconnects;
+	ofxViveTrackerRecorder recorder;
+	ofxViveTrackerPoseBus poseBus;
+	std::thread poseThread;
+	std::atomic<bool> poseThreadRunning;
+	std::atomic<uint64_t> trackedMask;
+	std::atomic<uint64_t> droppedSamples;
+
+	ofxViveTrackerPropertyCache propertyCache;
+	bool propertyCacheEnabled;
+	float propertyRefreshInterval;
+
+	std::atomic<vr::ETrackingUniverseOrigin> trackingUniverse;
+	std::atomic<Prediction> prediction;
+	std::atomic<float> predictionHorizon;
+	std::atomic<std::chrono::steady_clock::rep> predictionTarget;
+	std::atomic<float> predictionSeconds;
+	float displayFrequency;
+	float vsyncToPhotons;
+	ofxViveTrackerClock clock;
+	ofxViveTrackerProfiler profiler;
+	// Poses of this update converted in one pass for the filters, by
+	// device index
+	ofxViveTrackerPoseBatch converted;
+	ofxViveTrackerCalibration calibration;
+	ofxViveTrackerPoseHistory history;
+
+	Filter filterMode;
+	ofxViveTrackerOneEuroFilter filter;
+	uint64_t filterPending;
+	ofxViveTrackerKalmanFilter::Settings kalmanSettings;
+	ofxViveTrackerKalmanFilter kalmanFilters[vr::k_unMaxTrackedDeviceCount];
+
+	void scanDevices();
+	void refreshDevice(vr::TrackedDeviceIndex_t index);
+	void handleDeviceEvent(const vr::VREvent_t& event);
+	void setDeviceSerial(vr::TrackedDeviceIndex_t index, const std::string& serial);
+	bool findTrackers();
+	bool findSingleTracker();
+	void addTracker(vr::TrackedDeviceIndex_t index);
+	// haveSample when the disconnect came in as a pose, already in samples
+	void disconnectTracker(size_t slot, bool haveSample = false);
+	void addDisconnect(size_t slot);
+	void flushDisconnects();
+	void clearTrackers();
+	size_t getFirstConnectedSlot() const;
+	void markTrackersDisconnected();
+	void publishTrackedMask();
+	void updateSession();
+	void publishPoseBus();
+	void beginSession();
+	void endSession();
+	void startConnectThread();
+	void stopConnectThread();
+	void connectThreadFunction();
+	std::chrono::steady_clock::duration getBackoff(int failures, float jitter) const;
+	bool connectSource();
+	void startPoseThread();
+	void stopPoseThread();
+	void startPropertyCache();
+	void poseThreadFunction();
+	void readDisplayTiming();
+	float computePredictionSeconds(std::chrono::steady_clock::time_point now, bool haveVsync, float secondsSinceVsync);
+	void fetchPoses(vr::TrackedDevicePose_t* poses, std::chrono::steady_clock::time_point& time, uint64_t& frame);
 	void updatePose();
-	glm::mat4 convertMatrix(const vr::HmdMatrix34_t& mat);
-	glm::quat matrixToQuat(const glm::mat4& mat);
+	void drainSamples();
+	void filterPoses();
+	void resetFilters();
+	void addSample(size_t slot, const ofxViveTrackerSample& sample);
+	size_t getConvertCount() const;
+	void calibratePoses(vr::TrackedDevicePose_t* poses) const;
+	void applyPose(size_t slot, const vr::TrackedDevicePose_t& p, std::chrono::steady_clock::time_point time, uint64_t frame);
+	void updateConnectionState();
+	void updateDevice(ofxViveTrackerRawPose& pose, const vr::TrackedDevicePose_t& p);
 };
@@ -0,0 +1,138 @@
+#include "ofxViveTrackerBroadcaster.h"
+
+const char ofxViveTrackerBroadcaster::magic[4] = { 'O', 'V', 'T', 'B' };
+
+namespace {
+	template<class T>
+	inline uint8_t* write(uint8_t* out, T value) {
+		memcpy(out, &value, sizeof(value));
+		return out + sizeof(value);
+	}
+}
+
+ofxViveTrackerBroadcaster::ofxViveTrackerBroadcaster()
+	: buffer(maxPacketSize)
+	, sequence(0)
+	, serialInterval(100)
+	, sinceSerials(0)
+	, keyframeInterval(10)
+	, sinceKeyframe(0)
+	, lastNumTrackers(0)
+	, lastPacketSize(0) {
+}
+
+bool ofxViveTrackerBroadcaster::setup(const std::string& host, int port) {
+	if (!socket.open()) {
+		ofLogError("ofxViveTracker") << "Could not open UDP socket";
+		return false;
+	}
+	sequence = 0;
+	lastNumTrackers = 0;
+	return addDestination(host, port);
+}
+
+bool ofxViveTrackerBroadcaster::addDestination(const std::string& host, int port) {
+	if (!socket.addDestination(host, port)) {
+		ofLogError("ofxViveTracker") << "Could not resolve " << host;
+		return false;
+	}
+	ofLogNotice("ofxViveTracker") << "Broadcasting poses to " << host << ":" << port;
+	return true;
+}
+
+void ofxViveTrackerBroadcaster::close() {
+	socket.close();
+	socket.clearDestinations();
+}
+
+bool ofxViveTrackerBroadcaster::isSetup() const {
+	return socket.isOpen() && socket.getNumDestinations() > 0;
+}
+
+void ofxViveTrackerBroadcaster::setCodecSettings(const ofxViveTrackerCodec::Settings& settings) {
+	codec.setup(settings);
+	// The codec forgot the previous samples
+	sinceKeyframe = keyframeInterval;
+}
+
+void ofxViveTrackerBroadcaster::setSerialInterval(uint32_t datagrams) {
+	serialInterval = std::max(datagrams, 1u);
+}
+
+void ofxViveTrackerBroadcaster::setKeyframeInterval(uint32_t datagrams) {
+	keyframeInterval = std::max(datagrams, 1u);
+}
+
+bool ofxViveTrackerBroadcaster::send(const ofxViveTracker& tracker) {
+	if (!isSetup()) {
+		return false;
+	}
+
+	size_t numTrackers = tracker.getNumTrackers();
+	bool sendSerials = sequence == 0 || numTrackers > lastNumTrackers || ++sinceSerials >= serialInterval;
+	if (sendSerials) {
+		sinceSerials = 0;
+	}
+	lastNumTrackers = numTrackers;
+	bool keyframe = sequence == 0 || ++sinceKeyframe >= keyframeInterval;
+	if (keyframe) {
+		sinceKeyframe = 0;
+	}
+
+	auto steadyNow = std::chrono::steady_clock::now();
+	auto systemNow = std::chrono::system_clock::now();
+	uint8_t* p = buffer.data();
+	memcpy(p, magic, sizeof(magic));
+	p += sizeof(magic);
+	p = write<uint8_t>(p, version);
+	p = write<uint8_t>(p, (sendSerials ? 1 : 0) | (keyframe ? 2 : 0));
+	p = write<uint8_t>(p, (uint8_t) numTrackers);
+	p = write<uint8_t>(p, 0);
+	p = write<uint32_t>(p, sequence);
+	p = write<int64_t>(p, std::chrono::duration_cast<std::chrono::microseconds>(steadyNow.time_since_epoch()).count());
+	p = write<int64_t>(p, std::chrono::duration_cast<std::chrono::microseconds>(systemNow.time_since_epoch()).count());
+
+	if (sendSerials) {
+		for (size_t slot = 0; slot < numTrackers; slot++) {
+			const std::string& serial = tracker.getTracker(slot).serial;
+			uint8_t length = (uint8_t) std::min(serial.size(), maxSerialLength);
+			*p++ = length;
+			memcpy(p, serial.data(), length);
+			p += length;
+		}
+	}
+
+	for (size_t slot = 0; slot < numTrackers; slot++) {
+		const ofxViveTrackerDevice& device = tracker.getTracker(slot);
+		if (device.index >= vr::k_unMaxTrackedDeviceCount) {
+			*p++ = noDevice;
+			continue;
+		}
+		ofxViveTrackerSample sample;
+		sample.time = device.raw.time;
+		sample.frame = device.raw.frame;
+		sample.index = device.index;
+		vr::TrackedDevicePose_t& pose = sample.pose;
+		pose.bDeviceIsConnected = device.connected;
+		pose.bPoseIsValid = device.raw.tracking;
+		pose.eTrackingResult = device.raw.trackingResult;
+		pose.mDeviceToAbsoluteTracking = device.raw.matrix;
+		for (int axis = 0; axis < 3; axis++) {
+			pose.vVelocity.v[axis] = device.raw.velocity[axis];
+			pose.vAngularVelocity.v[axis] = device.raw.angularVelocity[axis];
+		}
+		p += codec.encode(sample, p, keyframe);
+	}
+
+	lastPacketSize = p - buffer.data();
+	sequence++;
+	return socket.send(buffer.data(), lastPacketSize) > 0;
+}
+
+uint32_t ofxViveTrackerBroadcaster::getSequence() const {
+	return sequence;
+}
+
+size_t ofxViveTrackerBroadcaster::getLastPacketSize() const {
+	return lastPacketSize;
+}
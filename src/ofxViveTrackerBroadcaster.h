@@ -0,0 +1,79 @@
+#pragma once
+
+#include "ofxViveTracker.h"
+#include "ofxViveTrackerCodec.h"
+#include "ofxViveTrackerUdpSocket.h"
+
+// Sends the tracker table to other machines over UDP, one datagram per
+// update(). Receive it with ofxViveTrackerReceiver.
+//
+// Datagram layout, little-endian:
+//
+//   char[4]   "OVTB"
+//   uint8     version
+//   uint8     flags, bit 0: serial numbers follow the header,
+//             bit 1: keyframe
+//   uint8     number of slots
+//   uint8     reserved
+//   uint32    sequence number, one per datagram
+//   int64     sender steady_clock microseconds when the datagram was built
+//   int64     sender system_clock microseconds at the same instant
+//   [serials] per slot: uint8 length, then that many characters
+//   poses     per slot: one sample encoded with ofxViveTrackerCodec, or
+//             noDevice for a slot waiting for its tracker
+//
+// Samples are delta coded against the previous datagram, with a keyframe
+// every few datagrams that a receiver can start from. A lost datagram
+// leaves the receiver waiting for the next keyframe, so the interval trades
+// bandwidth for how long a loss freezes the poses; 1 makes every datagram
+// stand alone.
+//
+// Serial numbers are sent with the first datagram, whenever the table
+// grows, and every few datagrams after that for late joiners.
+class ofxViveTrackerBroadcaster {
+public:
+	static const char magic[4];
+	static const uint8_t version = 2;
+	// In place of a sample, never a device index
+	static const uint8_t noDevice = 0xff;
+	static constexpr size_t headerSize = 28;
+	static constexpr size_t maxSerialLength = 31;
+	static constexpr size_t maxPacketSize = headerSize
+		+ vr::k_unMaxTrackedDeviceCount * (1 + maxSerialLength)
+		+ vr::k_unMaxTrackedDeviceCount * ofxViveTrackerCodec::maxEncodedSize;
+
+	ofxViveTrackerBroadcaster();
+
+	// Opens the socket and adds a first destination.
+	bool setup(const std::string& host, int port);
+	// Every datagram goes to all destinations in one batched send.
+	bool addDestination(const std::string& host, int port);
+	void close();
+	bool isSetup() const;
+
+	// Must match the receivers.
+	void setCodecSettings(const ofxViveTrackerCodec::Settings& settings);
+	// Datagrams between repeats of the serial numbers.
+	void setSerialInterval(uint32_t datagrams);
+	// Datagrams between keyframes, default 10.
+	void setKeyframeInterval(uint32_t datagrams);
+
+	// Sends the state left by the last tracker.update(). Call from the
+	// thread that calls update().
+	bool send(const ofxViveTracker& tracker);
+
+	uint32_t getSequence() const;
+	size_t getLastPacketSize() const;
+
+private:
+	ofxViveTrackerUdpSocket socket;
+	ofxViveTrackerCodec codec;
+	std::vector<uint8_t> buffer;
+	uint32_t sequence;
+	uint32_t serialInterval;
+	uint32_t sinceSerials;
+	uint32_t keyframeInterval;
+	uint32_t sinceKeyframe;
+	size_t lastNumTrackers;
+	size_t lastPacketSize;
+};
@@ -0,0 +1,77 @@
+#include "ofxViveTrackerCalibration.h"
+#include "ofxViveTrackerMath.h"
+
+ofxViveTrackerCalibration::ofxViveTrackerCalibration()
+	: world(1.0f)
+	, worldIdentity(true)
+	, localMask(0) {
+	ofxViveTrackerMath::toMatrix(world, worldMatrix);
+	clearLocalOffsets();
+}
+
+void ofxViveTrackerCalibration::setWorldTransform(const glm::mat4& transform) {
+	world = transform;
+	ofxViveTrackerMath::toMatrix(world, worldMatrix);
+	worldIdentity = world == glm::mat4(1.0f);
+}
+
+const glm::mat4& ofxViveTrackerCalibration::getWorldTransform() const {
+	return world;
+}
+
+void ofxViveTrackerCalibration::setLocalOffset(size_t slot, const glm::mat4& offset) {
+	if (slot >= maxSlots) return;
+	local[slot] = offset;
+	ofxViveTrackerMath::toMatrix(offset, localMatrices[slot]);
+	uint64_t bit = uint64_t(1) << slot;
+	localMask = offset == glm::mat4(1.0f) ? localMask & ~bit : localMask | bit;
+}
+
+const glm::mat4& ofxViveTrackerCalibration::getLocalOffset(size_t slot) const {
+	return local[std::min<size_t>(slot, maxSlots - 1)];
+}
+
+void ofxViveTrackerCalibration::clearLocalOffsets() {
+	for (size_t slot = 0; slot < maxSlots; slot++) {
+		local[slot] = glm::mat4(1.0f);
+		ofxViveTrackerMath::toMatrix(local[slot], localMatrices[slot]);
+	}
+	localMask = 0;
+}
+
+bool ofxViveTrackerCalibration::isIdentity() const {
+	return worldIdentity && !localMask;
+}
+
+void ofxViveTrackerCalibration::apply(size_t slot, vr::TrackedDevicePose_t& pose) const {
+	bool hasLocal = slot < maxSlots && (localMask & (uint64_t(1) << slot));
+	if (worldIdentity && !hasLocal) return;
+
+	vr::HmdMatrix34_t& mat = pose.mDeviceToAbsoluteTracking;
+	glm::vec3 velocity(pose.vVelocity.v[0], pose.vVelocity.v[1], pose.vVelocity.v[2]);
+	glm::vec3 angularVelocity(pose.vAngularVelocity.v[0], pose.vAngularVelocity.v[1], pose.vAngularVelocity.v[2]);
+
+	vr::HmdMatrix34_t offset;
+	if (hasLocal) {
+		const vr::HmdMatrix34_t& l = localMatrices[slot];
+		// The offset point moves with the tracker's rotation too
+		glm::vec3 lever = ofxViveTrackerMath::rotate(mat, ofxViveTrackerMath::toPosition(l));
+		velocity += glm::cross(angularVelocity, lever);
+		ofxViveTrackerMath::multiply(mat, l, offset);
+	} else {
+		offset = mat;
+	}
+
+	if (worldIdentity) {
+		mat = offset;
+	} else {
+		ofxViveTrackerMath::multiply(worldMatrix, offset, mat);
+		velocity = ofxViveTrackerMath::rotate(worldMatrix, velocity);
+		angularVelocity = ofxViveTrackerMath::rotate(worldMatrix, angularVelocity);
+	}
+
+	for (int axis = 0; axis < 3; axis++) {
+		pose.vVelocity.v[axis] = velocity[axis];
+		pose.vAngularVelocity.v[axis] = angularVelocity[axis];
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ofMain.h"
+#include <openvr.h>
+
+// Room calibration and per-tracker offsets, applied to poses as they are
+// converted:
+//
+//   pose' = world * pose * local[slot]
+//
+// Both are kept as 3x4 so a calibrated pose costs one 3x4 product (two with
+// a local offset) and an identity calibration costs nothing. Velocities
+// are moved along: the linear velocity becomes that of the offset point
+// and both are rotated into the world frame.
+//
+// Transforms are expected to be rigid (rotation and translation), since
+// orientations are derived from the calibrated matrix.
+class ofxViveTrackerCalibration {
+public:
+	enum {
+		maxSlots = vr::k_unMaxTrackedDeviceCount
+	};
+
+	ofxViveTrackerCalibration();
+
+	void setWorldTransform(const glm::mat4& world);
+	const glm::mat4& getWorldTransform() const;
+
+	// Offset in the tracker's own frame, e.g. a translation to a pen tip.
+	void setLocalOffset(size_t slot, const glm::mat4& offset);
+	const glm::mat4& getLocalOffset(size_t slot) const;
+	void clearLocalOffsets();
+
+	bool isIdentity() const;
+	// Calibrates the matrix and velocities of one pose in place.
+	void apply(size_t slot, vr::TrackedDevicePose_t& pose) const;
+
+private:
+	glm::mat4 world;
+	glm::mat4 local[maxSlots];
+	vr::HmdMatrix34_t worldMatrix;
+	vr::HmdMatrix34_t localMatrices[maxSlots];
+	bool worldIdentity;
+	uint64_t localMask;
+};
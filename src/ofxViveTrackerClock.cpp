@@ -0,0 +1,92 @@
+#include "ofxViveTrackerClock.h"
+
+ofxViveTrackerClock::ofxViveTrackerClock() {
+	reset();
+}
+
+void ofxViveTrackerClock::reset() {
+	count = 0;
+	next = 0;
+	lastFrame = 0;
+
+	Fit empty;
+	empty.valid = false;
+	empty.frameOrigin = 0;
+	empty.timeOrigin = TimePoint();
+	empty.secondsPerFrame = 0.0;
+	empty.offset = 0.0;
+	fit.store(empty);
+}
+
+void ofxViveTrackerClock::addObservation(TimePoint now, float secondsSinceVsync, uint64_t frame) {
+	// One observation per frame is enough, the rest only add noise
+	if (count > 0 && frame == lastFrame) return;
+
+	// The counter restarts when SteamVR does
+	if (count > 0 && frame < lastFrame) {
+		reset();
+	}
+	lastFrame = frame;
+
+	auto sinceVsync = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(secondsSinceVsync));
+	frames[next] = frame;
+	vsyncs[next] = now - sinceVsync;
+	next = (next + 1) % windowSize;
+	if (count < windowSize) count++;
+
+	refit();
+}
+
+void ofxViveTrackerClock::refit() {
+	if (count < 2) return;
+
+	// Fit seconds = offset + secondsPerFrame * frames, relative to the
+	// newest observation to keep the doubles well conditioned
+	int newest = (next + windowSize - 1) % windowSize;
+	uint64_t frameOrigin = frames[newest];
+	TimePoint timeOrigin = vsyncs[newest];
+
+	double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+	for (int i = 0; i < count; i++) {
+		double x = -double(frameOrigin - frames[i]);
+		double y = std::chrono::duration<double>(vsyncs[i] - timeOrigin).count();
+		sumX += x;
+		sumY += y;
+		sumXX += x * x;
+		sumXY += x * y;
+	}
+
+	double n = count;
+	double denom = n * sumXX - sumX * sumX;
+	if (denom <= 0.0) return;
+
+	Fit f;
+	f.valid = true;
+	f.frameOrigin = frameOrigin;
+	f.timeOrigin = timeOrigin;
+	f.secondsPerFrame = (n * sumXY - sumX * sumY) / denom;
+	f.offset = (sumY - f.secondsPerFrame * sumX) / n;
+	fit.store(f);
+}
+
+bool ofxViveTrackerClock::isValid() const {
+	return fit.load().valid;
+}
+
+ofxViveTrackerClock::TimePoint ofxViveTrackerClock::getTimeOfFrame(double frame) const {
+	Fit f = fit.load();
+	if (!f.valid) return TimePoint();
+	double seconds = f.offset + f.secondsPerFrame * (frame - double(f.frameOrigin));
+	return f.timeOrigin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+double ofxViveTrackerClock::getFrameAtTime(TimePoint time) const {
+	Fit f = fit.load();
+	if (!f.valid || f.secondsPerFrame <= 0.0) return 0.0;
+	double seconds = std::chrono::duration<double>(time - f.timeOrigin).count();
+	return double(f.frameOrigin) + (seconds - f.offset) / f.secondsPerFrame;
+}
+
+double ofxViveTrackerClock::getFramePeriod() const {
+	return fit.load().secondsPerFrame;
+}
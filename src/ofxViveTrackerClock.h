@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ofxViveTrackerSeqLock.h"
+#include <chrono>
+#include <cstdint>
+
+// Maps between std::chrono::steady_clock and the OpenVR vsync frame counter.
+// Each observation pins the vsync of one frame to a steady_clock instant, and
+// a least-squares line through the most recent frames gives the frame period
+// and phase. Conversions are safe from any thread; observations must come
+// from one thread at a time.
+class ofxViveTrackerClock {
+public:
+	typedef std::chrono::steady_clock::time_point TimePoint;
+
+	ofxViveTrackerClock();
+
+	void addObservation(TimePoint now, float secondsSinceVsync, uint64_t frame);
+	void reset();
+
+	// False until at least two different frames have been observed.
+	bool isValid() const;
+
+	// steady_clock instant of the vsync that started frame (fractional
+	// frames interpolate between vsyncs).
+	TimePoint getTimeOfFrame(double frame) const;
+	// Frame counter at the given instant, fractional between vsyncs.
+	double getFrameAtTime(TimePoint time) const;
+	// Estimated vsync period in seconds.
+	double getFramePeriod() const;
+
+private:
+	struct Fit {
+		bool valid;
+		uint64_t frameOrigin;
+		TimePoint timeOrigin;
+		double secondsPerFrame;
+		double offset; // seconds from timeOrigin at frameOrigin
+	};
+
+	static const int windowSize = 64;
+
+	uint64_t frames[windowSize];
+	TimePoint vsyncs[windowSize];
+	int count;
+	int next;
+	uint64_t lastFrame;
+
+	ofxViveTrackerSeqLock<Fit> fit;
+
+	void refit();
+};
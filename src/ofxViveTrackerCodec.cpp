@@ -0,0 +1,303 @@
+#include "ofxViveTrackerCodec.h"
+#include "ofxViveTrackerMath.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OFXVIVETRACKER_CODEC_SSE2
+#endif
+
+namespace {
+	enum {
+		FlagLargest = 0x03,
+		FlagConnected = 0x04,
+		FlagValid = 0x08,
+		FlagKeyframe = 0x10,
+		FlagTime = 0x20,
+		FlagFrame = 0x40,
+		FlagResult = 0x80
+	};
+
+	inline uint32_t zigzag(int32_t v) {
+		return ((uint32_t) v << 1) ^ (uint32_t) (v >> 31);
+	}
+
+	inline int32_t unzigzag(uint32_t v) {
+		return (int32_t) (v >> 1) ^ -(int32_t) (v & 1);
+	}
+
+	inline uint64_t zigzag64(int64_t v) {
+		return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+	}
+
+	inline int64_t unzigzag64(uint64_t v) {
+		return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+	}
+
+	inline uint8_t* writeVarint(uint8_t* out, uint64_t v) {
+		while (v >= 0x80) {
+			*out++ = (uint8_t) (v | 0x80);
+			v >>= 7;
+		}
+		*out++ = (uint8_t) v;
+		return out;
+	}
+
+	inline bool readVarint(const uint8_t*& in, const uint8_t* end, uint64_t& v, int maxBytes) {
+		v = 0;
+		for (int i = 0; i < maxBytes && in < end; i++) {
+			uint8_t byte = *in++;
+			v |= (uint64_t) (byte & 0x7f) << (7 * i);
+			if (!(byte & 0x80)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	inline int32_t quantize(float value, float scale) {
+		return (int32_t) std::lround(value * scale);
+	}
+
+	inline int64_t toMicroseconds(std::chrono::steady_clock::time_point time) {
+		return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+	}
+}
+
+ofxViveTrackerCodec::ofxViveTrackerCodec() {
+	setup(Settings());
+}
+
+void ofxViveTrackerCodec::setup(const Settings& settings) {
+	this->settings = settings;
+	this->settings.orientationBits = std::max(8, std::min(this->settings.orientationBits, 24));
+
+	// The three smallest components of a unit quaternion are within
+	// +-1/sqrt(2), map that range onto the signed integer range
+	int maxValue = (1 << (this->settings.orientationBits - 1)) - 1;
+	orientationScale = maxValue * std::sqrt(2.0f);
+
+	for (int i = 0; i < 3; i++) {
+		fieldScale[i] = 1.0f / settings.positionStep;
+		fieldScale[3 + i] = orientationScale;
+		fieldScale[6 + i] = 1.0f / settings.velocityStep;
+		fieldScale[9 + i] = 1.0f / settings.angularVelocityStep;
+	}
+	for (int i = 0; i < numFields; i++) {
+		fieldStep[i] = 1.0f / fieldScale[i];
+	}
+	reset();
+}
+
+const ofxViveTrackerCodec::Settings& ofxViveTrackerCodec::getSettings() const {
+	return settings;
+}
+
+void ofxViveTrackerCodec::reset() {
+	for (DeviceState& device : devices) {
+		resetDevice(device);
+	}
+	previousTime = 0;
+	previousFrame = 0;
+}
+
+void ofxViveTrackerCodec::resetDevice(DeviceState& device) {
+	for (int i = 0; i < numFields; i++) {
+		device.fields[i] = 0;
+	}
+	device.trackingResult = vr::TrackingResult_Running_OK;
+	device.largest = 3;
+}
+
+size_t ofxViveTrackerCodec::encode(const ofxViveTrackerSample& sample, uint8_t* out, bool keyframe) {
+	if (sample.index >= vr::k_unMaxTrackedDeviceCount) {
+		return 0;
+	}
+	const vr::TrackedDevicePose_t& pose = sample.pose;
+	DeviceState& device = devices[sample.index];
+	if (keyframe) {
+		resetDevice(device);
+		previousTime = 0;
+		previousFrame = 0;
+	}
+
+	int64_t time = toMicroseconds(sample.time);
+	uint8_t flags = 0;
+	if (pose.bDeviceIsConnected) flags |= FlagConnected;
+	if (pose.bPoseIsValid) flags |= FlagValid;
+	if (keyframe) flags |= FlagKeyframe;
+	if (time != previousTime) flags |= FlagTime;
+	if (sample.frame != previousFrame) flags |= FlagFrame;
+	if ((uint32_t) pose.eTrackingResult != device.trackingResult) flags |= FlagResult;
+
+	int32_t fields[numFields];
+	uint8_t largest = device.largest;
+	if (pose.bPoseIsValid) {
+		glm::quat q = ofxViveTrackerMath::toQuat(pose.mDeviceToAbsoluteTracking);
+		float components[4] = { q.x, q.y, q.z, q.w };
+		largest = 0;
+		for (uint8_t i = 1; i < 4; i++) {
+			if (std::abs(components[i]) > std::abs(components[largest])) {
+				largest = i;
+			}
+		}
+		// q and -q are the same rotation, keep the largest component positive
+		// so it can be rebuilt from the other three
+		float sign = components[largest] < 0 ? -1.0f : 1.0f;
+		int32_t maxValue = (1 << (settings.orientationBits - 1)) - 1;
+		for (int i = 0, j = 0; i < 4; i++) {
+			if (i != largest) {
+				int32_t value = quantize(components[i] * sign, orientationScale);
+				fields[3 + j++] = std::max(-maxValue, std::min(value, maxValue));
+			}
+		}
+		for (int axis = 0; axis < 3; axis++) {
+			fields[axis] = quantize(pose.mDeviceToAbsoluteTracking.m[axis][3], fieldScale[axis]);
+			fields[6 + axis] = quantize(pose.vVelocity.v[axis], fieldScale[6 + axis]);
+			fields[9 + axis] = quantize(pose.vAngularVelocity.v[axis], fieldScale[9 + axis]);
+		}
+	}
+	flags |= largest;
+
+	uint8_t* p = out;
+	*p++ = (uint8_t) sample.index;
+	*p++ = flags;
+	if (flags & FlagTime) {
+		p = writeVarint(p, zigzag64(time - previousTime));
+		previousTime = time;
+	}
+	if (flags & FlagFrame) {
+		p = writeVarint(p, zigzag64((int64_t) (sample.frame - previousFrame)));
+		previousFrame = sample.frame;
+	}
+	if (flags & FlagResult) {
+		device.trackingResult = (uint32_t) pose.eTrackingResult;
+		p = writeVarint(p, device.trackingResult);
+	}
+	if (pose.bPoseIsValid) {
+		for (int i = 0; i < numFields; i++) {
+			int32_t delta = (int32_t) ((uint32_t) fields[i] - (uint32_t) device.fields[i]);
+			p = writeVarint(p, zigzag(delta));
+			device.fields[i] = fields[i];
+		}
+		device.largest = largest;
+	}
+	return p - out;
+}
+
+size_t ofxViveTrackerCodec::decode(const uint8_t* in, size_t size, ofxViveTrackerSample& sample) {
+	const uint8_t* p = in;
+	const uint8_t* end = in + size;
+	if (size < 2 || p[0] >= vr::k_unMaxTrackedDeviceCount) {
+		return 0;
+	}
+	vr::TrackedDeviceIndex_t index = *p++;
+	uint8_t flags = *p++;
+	DeviceState& device = devices[index];
+	if (flags & FlagKeyframe) {
+		resetDevice(device);
+		previousTime = 0;
+		previousFrame = 0;
+	}
+
+	uint64_t value;
+	if (flags & FlagTime) {
+		if (!readVarint(p, end, value, 10)) return 0;
+		previousTime += unzigzag64(value);
+	}
+	if (flags & FlagFrame) {
+		if (!readVarint(p, end, value, 10)) return 0;
+		previousFrame += (uint64_t) unzigzag64(value);
+	}
+	if (flags & FlagResult) {
+		if (!readVarint(p, end, value, 5)) return 0;
+		device.trackingResult = (uint32_t) value;
+	}
+	if (flags & FlagValid) {
+		if (!decodeFields(p, end, device)) return 0;
+		device.largest = flags & FlagLargest;
+	}
+
+	float values[numFields];
+	dequantize(device, values);
+
+	// Rebuild the largest component from the unit length
+	float small[3] = { values[3], values[4], values[5] };
+	float sum = small[0] * small[0] + small[1] * small[1] + small[2] * small[2];
+	float components[4];
+	for (int i = 0, j = 0; i < 4; i++) {
+		components[i] = (i == device.largest) ? std::sqrt(std::max(0.0f, 1.0f - sum)) : small[j++];
+	}
+	glm::quat q;
+	q.x = components[0];
+	q.y = components[1];
+	q.z = components[2];
+	q.w = components[3];
+
+	sample.time = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::microseconds(previousTime)));
+	sample.frame = previousFrame;
+	sample.index = index;
+	vr::TrackedDevicePose_t& pose = sample.pose;
+	pose.bDeviceIsConnected = (flags & FlagConnected) != 0;
+	pose.bPoseIsValid = (flags & FlagValid) != 0;
+	pose.eTrackingResult = (vr::ETrackingResult) device.trackingResult;
+	ofxViveTrackerMath::toMatrix(q, glm::vec3(values[0], values[1], values[2]), pose.mDeviceToAbsoluteTracking);
+	for (int axis = 0; axis < 3; axis++) {
+		pose.vVelocity.v[axis] = values[6 + axis];
+		pose.vAngularVelocity.v[axis] = values[9 + axis];
+	}
+	return p - in;
+}
+
+bool ofxViveTrackerCodec::decodeFields(const uint8_t*& in, const uint8_t* end, DeviceState& device) {
+#ifdef OFXVIVETRACKER_CODEC_SSE2
+	// Fast path for the common case where all twelve deltas fit in one byte:
+	// widen, unzigzag and accumulate four fields per instruction
+	if (end - in >= 16) {
+		__m128i bytes = _mm_loadu_si128((const __m128i*) in);
+		if ((_mm_movemask_epi8(bytes) & 0xfff) == 0) {
+			__m128i zero = _mm_setzero_si128();
+			__m128i one = _mm_set1_epi32(1);
+			__m128i lo = _mm_unpacklo_epi8(bytes, zero);
+			__m128i hi = _mm_unpackhi_epi8(bytes, zero);
+			__m128i zigzags[3] = {
+				_mm_unpacklo_epi16(lo, zero),
+				_mm_unpackhi_epi16(lo, zero),
+				_mm_unpacklo_epi16(hi, zero)
+			};
+			for (int i = 0; i < 3; i++) {
+				__m128i sign = _mm_sub_epi32(zero, _mm_and_si128(zigzags[i], one));
+				__m128i delta = _mm_xor_si128(_mm_srli_epi32(zigzags[i], 1), sign);
+				__m128i* fields = (__m128i*) (device.fields + 4 * i);
+				_mm_storeu_si128(fields, _mm_add_epi32(_mm_loadu_si128(fields), delta));
+			}
+			in += numFields;
+			return true;
+		}
+	}
+#endif
+	int32_t fields[numFields];
+	for (int i = 0; i < numFields; i++) {
+		uint64_t value;
+		if (!readVarint(in, end, value, 5)) {
+			return false;
+		}
+		fields[i] = (int32_t) ((uint32_t) device.fields[i] + (uint32_t) unzigzag((uint32_t) value));
+	}
+	for (int i = 0; i < numFields; i++) {
+		device.fields[i] = fields[i];
+	}
+	return true;
+}
+
+void ofxViveTrackerCodec::dequantize(const DeviceState& device, float* values) const {
+#ifdef OFXVIVETRACKER_CODEC_SSE2
+	for (int i = 0; i < numFields; i += 4) {
+		__m128i fields = _mm_loadu_si128((const __m128i*) (device.fields + i));
+		_mm_storeu_ps(values + i, _mm_mul_ps(_mm_cvtepi32_ps(fields), _mm_loadu_ps(fieldStep + i)));
+	}
+#else
+	for (int i = 0; i < numFields; i++) {
+		values[i] = device.fields[i] * fieldStep[i];
+	}
+#endif
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "ofxViveTrackerSource.h"
+
+// Compact encoding for streams of samples, for recording and networking.
+//
+// Each sample is quantized and then delta coded against the previous
+// sample of the same device:
+//
+//   position           fixed point, positionStep meters per unit
+//   orientation        smallest three: index of the largest component
+//                      plus the other three in orientationBits each
+//   velocity           fixed point, velocityStep meters/second per unit
+//   angular velocity   fixed point, angularVelocityStep radians/second
+//   time, frame        delta against the previous sample in the stream,
+//                      omitted when unchanged
+//
+// Deltas are zigzag varints, so small movements cost one byte per field.
+// A tracker sampled at 1kHz typically takes 14-16 bytes instead of the
+// 80 byte TrackedDevicePose_t.
+//
+// Every encoded sample is laid out as:
+//
+//   uint8    device index
+//   uint8    flags: largest component (2 bits), connected, valid,
+//            keyframe, time changed, frame changed, result changed
+//   varint   time delta in microseconds    (if time changed)
+//   varint   frame delta                   (if frame changed)
+//   varint   tracking result               (if result changed)
+//   varint   12 zigzag deltas: position, orientation, velocity,
+//            angular velocity              (if valid)
+//
+// A keyframe is coded against zero instead of the previous sample, so a
+// decoder can start from it. Encoder and decoder are separate instances
+// and must use the same Settings.
+class ofxViveTrackerCodec {
+public:
+	struct Settings {
+		float positionStep = 0.00005f;
+		float velocityStep = 0.0001f;
+		float angularVelocityStep = 0.0001f;
+		int orientationBits = 16;
+	};
+
+	// Upper bound for one encoded sample.
+	static constexpr size_t maxEncodedSize = 96;
+
+	ofxViveTrackerCodec();
+
+	void setup(const Settings& settings);
+	const Settings& getSettings() const;
+	// Forget the previous samples, so the next sample of every device is
+	// coded (or expected) as if it were a keyframe.
+	void reset();
+
+	// Writes at most maxEncodedSize bytes to out, returns the bytes written.
+	size_t encode(const ofxViveTrackerSample& sample, uint8_t* out, bool keyframe = false);
+	// Returns the bytes consumed, or 0 if the data is truncated or invalid.
+	size_t decode(const uint8_t* in, size_t size, ofxViveTrackerSample& sample);
+
+private:
+	enum {
+		numFields = 12
+	};
+
+	struct DeviceState {
+		int32_t fields[numFields];
+		uint32_t trackingResult;
+		uint8_t largest;
+	};
+
+	void resetDevice(DeviceState& device);
+	bool decodeFields(const uint8_t*& in, const uint8_t* end, DeviceState& device);
+	void dequantize(const DeviceState& device, float* values) const;
+
+	Settings settings;
+	float fieldScale[numFields];
+	float fieldStep[numFields];
+	float orientationScale;
+
+	DeviceState devices[vr::k_unMaxTrackedDeviceCount];
+	int64_t previousTime;
+	uint64_t previousFrame;
+};
@@ -0,0 +1,246 @@
+#include "ofxViveTrackerKalmanFilter.h"
+#include "ofxViveTrackerMath.h"
+
+void ofxViveTrackerKalmanFilter::Channel::initialize(int n, const glm::vec3& value, const glm::vec3& rate, float valueNoise, float rateNoise) {
+	order = n;
+	for (int axis = 0; axis < 3; axis++) {
+		x[axis][0] = value[axis];
+		x[axis][1] = rate[axis];
+		x[axis][2] = 0.0f;
+	}
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			P[i][j] = 0.0f;
+		}
+	}
+	P[0][0] = valueNoise * valueNoise;
+	P[1][1] = rateNoise * rateNoise;
+	// Unknown acceleration, let the first few updates find it
+	P[2][2] = order == 3 ? 100.0f : 0.0f;
+}
+
+void ofxViveTrackerKalmanFilter::Channel::predict(float dt, float q) {
+	// x = F x with F the kinematic transition
+	float dt2 = 0.5f * dt * dt;
+	for (int axis = 0; axis < 3; axis++) {
+		float* s = x[axis];
+		if (order == 3) {
+			s[0] += s[1] * dt + s[2] * dt2;
+			s[1] += s[2] * dt;
+		} else {
+			s[0] += s[1] * dt;
+		}
+	}
+
+	// P = F P F^T + Q
+	float F[3][3] = {
+		{ 1.0f, dt, order == 3 ? dt2 : 0.0f },
+		{ 0.0f, 1.0f, order == 3 ? dt : 0.0f },
+		{ 0.0f, 0.0f, order == 3 ? 1.0f : 0.0f }
+	};
+	float FP[3][3];
+	for (int i = 0; i < order; i++) {
+		for (int j = 0; j < order; j++) {
+			float sum = 0.0f;
+			for (int k = 0; k < order; k++) {
+				sum += F[i][k] * P[k][j];
+			}
+			FP[i][j] = sum;
+		}
+	}
+	for (int i = 0; i < order; i++) {
+		for (int j = 0; j < order; j++) {
+			float sum = 0.0f;
+			for (int k = 0; k < order; k++) {
+				sum += FP[i][k] * F[j][k];
+			}
+			P[i][j] = sum;
+		}
+	}
+
+	// Continuous white noise on the highest derivative
+	float dt3 = dt * dt * dt;
+	if (order == 3) {
+		float dt4 = dt3 * dt, dt5 = dt4 * dt;
+		P[0][0] += q * dt5 / 20.0f;
+		P[0][1] += q * dt4 / 8.0f;
+		P[0][2] += q * dt3 / 6.0f;
+		P[1][1] += q * dt3 / 3.0f;
+		P[1][2] += q * dt * dt / 2.0f;
+		P[2][2] += q * dt;
+		P[1][0] = P[0][1];
+		P[2][0] = P[0][2];
+		P[2][1] = P[1][2];
+	} else {
+		P[0][0] += q * dt3 / 3.0f;
+		P[0][1] += q * dt * dt / 2.0f;
+		P[1][1] += q * dt;
+		P[1][0] = P[0][1];
+	}
+}
+
+void ofxViveTrackerKalmanFilter::Channel::correct(const glm::vec3& value, const glm::vec3& rate, float valueNoise, float rateNoise) {
+	// Both value and rate are measured: H = [I 0], S = H P H^T + R
+	float s00 = P[0][0] + valueNoise * valueNoise;
+	float s01 = P[0][1];
+	float s11 = P[1][1] + rateNoise * rateNoise;
+	float det = s00 * s11 - s01 * s01;
+	if (det <= 0.0f) return;
+	float i00 = s11 / det, i01 = -s01 / det, i11 = s00 / det;
+
+	// K = P H^T S^-1
+	float K[3][2];
+	for (int i = 0; i < order; i++) {
+		K[i][0] = P[i][0] * i00 + P[i][1] * i01;
+		K[i][1] = P[i][0] * i01 + P[i][1] * i11;
+	}
+
+	for (int axis = 0; axis < 3; axis++) {
+		float* s = x[axis];
+		float y0 = value[axis] - s[0];
+		float y1 = rate[axis] - s[1];
+		for (int i = 0; i < order; i++) {
+			s[i] += K[i][0] * y0 + K[i][1] * y1;
+		}
+	}
+
+	// P = (I - K H) P, symmetrized against rounding
+	float row0[3] = { P[0][0], P[0][1], P[0][2] };
+	float row1[3] = { P[1][0], P[1][1], P[1][2] };
+	for (int i = 0; i < order; i++) {
+		for (int j = 0; j < order; j++) {
+			P[i][j] -= K[i][0] * row0[j] + K[i][1] * row1[j];
+		}
+	}
+	for (int i = 0; i < order; i++) {
+		for (int j = i + 1; j < order; j++) {
+			float mean = 0.5f * (P[i][j] + P[j][i]);
+			P[i][j] = P[j][i] = mean;
+		}
+	}
+}
+
+ofxViveTrackerKalmanFilter::ofxViveTrackerKalmanFilter()
+	: initialized(false)
+	, orientation(1.0f, 0.0f, 0.0f, 0.0f) {
+	position.initialize(2, glm::vec3(0.0f), glm::vec3(0.0f), 0.0f, 0.0f);
+	rotation.initialize(2, glm::vec3(0.0f), glm::vec3(0.0f), 0.0f, 0.0f);
+}
+
+void ofxViveTrackerKalmanFilter::setup(const Settings& s) {
+	settings = s;
+	reset();
+}
+
+const ofxViveTrackerKalmanFilter::Settings& ofxViveTrackerKalmanFilter::getSettings() const {
+	return settings;
+}
+
+void ofxViveTrackerKalmanFilter::reset() {
+	initialized = false;
+}
+
+bool ofxViveTrackerKalmanFilter::isInitialized() const {
+	return initialized;
+}
+
+void ofxViveTrackerKalmanFilter::update(std::chrono::steady_clock::time_point t, const glm::vec3& p, const glm::vec3& v, const glm::quat& q, const glm::vec3& w) {
+	bool constantAcceleration = settings.model == Model::ConstantAcceleration;
+	if (!initialized) {
+		position.initialize(constantAcceleration ? 3 : 2, p, v, settings.positionNoise, settings.velocityNoise);
+		rotation.initialize(2, glm::vec3(0.0f), w, settings.orientationNoise, settings.angularVelocityNoise);
+		orientation = q;
+		time = t;
+		initialized = true;
+		return;
+	}
+	if (t < time) {
+		return;
+	}
+
+	float dt = std::chrono::duration<float>(t - time).count();
+	time = t;
+	if (dt > 0.0f) {
+		position.predict(dt, constantAcceleration ? settings.jerkNoise : settings.accelerationNoise);
+		glm::vec3 angularVelocity = getAngularVelocity();
+		rotation.predict(dt, settings.angularAccelerationNoise);
+		// Angular velocity is in tracking space, so it applies on the left
+		orientation = glm::normalize(ofxViveTrackerMath::fromRotationVector(angularVelocity * dt) * orientation);
+		for (int axis = 0; axis < 3; axis++) {
+			rotation.x[axis][0] = 0.0f;
+		}
+	}
+
+	position.correct(p, v, settings.positionNoise, settings.velocityNoise);
+
+	// Measured rotation relative to the estimate, folded back in afterwards
+	rotation.correct(ofxViveTrackerMath::toRotationVector(q * glm::conjugate(orientation)), w, settings.orientationNoise, settings.angularVelocityNoise);
+	glm::vec3 error(rotation.x[0][0], rotation.x[1][0], rotation.x[2][0]);
+	orientation = glm::normalize(ofxViveTrackerMath::fromRotationVector(error) * orientation);
+	for (int axis = 0; axis < 3; axis++) {
+		rotation.x[axis][0] = 0.0f;
+	}
+}
+
+std::chrono::steady_clock::time_point ofxViveTrackerKalmanFilter::getTime() const {
+	return time;
+}
+
+glm::vec3 ofxViveTrackerKalmanFilter::getPosition() const {
+	return glm::vec3(position.x[0][0], position.x[1][0], position.x[2][0]);
+}
+
+glm::vec3 ofxViveTrackerKalmanFilter::getVelocity() const {
+	return glm::vec3(position.x[0][1], position.x[1][1], position.x[2][1]);
+}
+
+glm::vec3 ofxViveTrackerKalmanFilter::getAcceleration() const {
+	if (position.order < 3) return glm::vec3(0.0f);
+	return glm::vec3(position.x[0][2], position.x[1][2], position.x[2][2]);
+}
+
+glm::quat ofxViveTrackerKalmanFilter::getOrientation() const {
+	return orientation;
+}
+
+glm::vec3 ofxViveTrackerKalmanFilter::getAngularVelocity() const {
+	return glm::vec3(rotation.x[0][1], rotation.x[1][1], rotation.x[2][1]);
+}
+
+void ofxViveTrackerKalmanFilter::getEstimate(ofxViveTrackerPose& pose) const {
+	pose.position = getPosition();
+	pose.velocity = getVelocity();
+	pose.acceleration = getAcceleration();
+	pose.orientation = orientation;
+	pose.angularVelocity = getAngularVelocity();
+	pose.matrix = ofxViveTrackerMath::toMat4(pose.orientation, pose.position);
+}
+
+void ofxViveTrackerKalmanFilter::getEstimate(ofxViveTrackerRawPose& pose) const {
+	ofxViveTrackerMath::toMatrix(orientation, getPosition(), pose.matrix);
+	pose.velocity = getVelocity();
+	pose.acceleration = getAcceleration();
+	pose.angularVelocity = getAngularVelocity();
+}
+
+ofxViveTrackerPose ofxViveTrackerKalmanFilter::predict(std::chrono::steady_clock::time_point t) const {
+	ofxViveTrackerPose pose;
+	pose.tracking = initialized;
+	pose.time = time;
+	getEstimate(pose);
+	return extrapolate(pose, t);
+}
+
+ofxViveTrackerPose ofxViveTrackerKalmanFilter::extrapolate(const ofxViveTrackerPose& pose, std::chrono::steady_clock::time_point t) {
+	ofxViveTrackerPose predicted = pose;
+	predicted.time = t;
+	if (!pose.tracking) {
+		return predicted;
+	}
+	float dt = std::chrono::duration<float>(t - pose.time).count();
+	predicted.position = pose.position + pose.velocity * dt + pose.acceleration * (0.5f * dt * dt);
+	predicted.velocity = pose.velocity + pose.acceleration * dt;
+	predicted.orientation = glm::normalize(ofxViveTrackerMath::fromRotationVector(pose.angularVelocity * dt) * pose.orientation);
+	predicted.matrix = ofxViveTrackerMath::toMat4(predicted.orientation, predicted.position);
+	return predicted;
+}
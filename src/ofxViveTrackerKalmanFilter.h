@@ -0,0 +1,86 @@
+#pragma once
+
+#include "ofxViveTrackerPose.h"
+
+// Kalman filter for one tracker that fuses the measured position, velocity,
+// orientation and angular velocity into a smoothed estimate, and
+// extrapolates it to any time.
+//
+// Position follows a constant velocity or constant acceleration model.
+// Orientation follows a constant angular velocity model, filtered as a
+// small rotation error around the current estimate. The three axes see
+// the same measurements, so they share one covariance matrix. Everything
+// is fixed-size; nothing allocates.
+class ofxViveTrackerKalmanFilter {
+public:
+	enum class Model {
+		ConstantVelocity,
+		ConstantAcceleration
+	};
+
+	struct Settings {
+		Model model = Model::ConstantVelocity;
+
+		// Measurement noise, standard deviations
+		float positionNoise = 0.0005f;       // meters
+		float velocityNoise = 0.05f;         // meters per second
+		float orientationNoise = 0.002f;     // radians
+		float angularVelocityNoise = 0.05f;  // radians per second
+
+		// Process noise, spectral density of the unmodeled derivative:
+		// acceleration for constant velocity, jerk for constant acceleration
+		float accelerationNoise = 50.0f;     // m^2/s^3
+		float jerkNoise = 5000.0f;           // m^2/s^5
+		float angularAccelerationNoise = 100.0f; // rad^2/s^3
+	};
+
+	ofxViveTrackerKalmanFilter();
+
+	void setup(const Settings& settings);
+	const Settings& getSettings() const;
+	// The next measurement starts the filter again.
+	void reset();
+	bool isInitialized() const;
+
+	// Fuse one measurement. Measurements older than the last are ignored.
+	void update(std::chrono::steady_clock::time_point time, const glm::vec3& position, const glm::vec3& velocity, const glm::quat& orientation, const glm::vec3& angularVelocity);
+
+	std::chrono::steady_clock::time_point getTime() const;
+	glm::vec3 getPosition() const;
+	glm::vec3 getVelocity() const;
+	glm::vec3 getAcceleration() const;
+	glm::quat getOrientation() const;
+	glm::vec3 getAngularVelocity() const;
+
+	// Writes the estimate into the motion fields of pose (position,
+	// orientation, matrix and derivatives).
+	void getEstimate(ofxViveTrackerPose& pose) const;
+	void getEstimate(ofxViveTrackerRawPose& pose) const;
+	// Estimate extrapolated to time with the filter's motion model.
+	ofxViveTrackerPose predict(std::chrono::steady_clock::time_point time) const;
+
+	// Kinematic extrapolation of any pose from its velocity, angular
+	// velocity and acceleration. Same as predict() for a filtered pose.
+	static ofxViveTrackerPose extrapolate(const ofxViveTrackerPose& pose, std::chrono::steady_clock::time_point time);
+
+private:
+	// Value, rate and optionally acceleration along three axes, with the
+	// covariance they share.
+	struct Channel {
+		int order;
+		float x[3][3];
+		float P[3][3];
+
+		void initialize(int order, const glm::vec3& value, const glm::vec3& rate, float valueNoise, float rateNoise);
+		void predict(float dt, float processNoise);
+		void correct(const glm::vec3& value, const glm::vec3& rate, float valueNoise, float rateNoise);
+	};
+
+	Settings settings;
+	bool initialized;
+	std::chrono::steady_clock::time_point time;
+	Channel position;
+	// Rotation error around orientation, kept at zero between updates
+	Channel rotation;
+	glm::quat orientation;
+};
@@ -0,0 +1,194 @@
+#include "ofxViveTrackerMappedFile.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+ofxViveTrackerMappedFile::ofxViveTrackerMappedFile()
+	: mode(Mode::Read)
+	, size(0)
+	, file(INVALID_HANDLE_VALUE)
+	, mapping(nullptr) {
+}
+
+ofxViveTrackerMappedFile::~ofxViveTrackerMappedFile() {
+	close();
+}
+
+bool ofxViveTrackerMappedFile::open(const std::string& path, Mode m) {
+	close();
+	mode = m;
+	if (mode == Mode::Write) {
+		file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	} else {
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	}
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	size = fileSize.QuadPart;
+	return true;
+}
+
+void ofxViveTrackerMappedFile::close() {
+	if (mapping) {
+		CloseHandle(mapping);
+		mapping = nullptr;
+	}
+	if (file != INVALID_HANDLE_VALUE) {
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+	}
+	size = 0;
+}
+
+bool ofxViveTrackerMappedFile::isOpen() const {
+	return file != INVALID_HANDLE_VALUE;
+}
+
+bool ofxViveTrackerMappedFile::resize(uint64_t newSize) {
+	// The mapping object has a fixed size, views outlive the handle
+	if (mapping) {
+		CloseHandle(mapping);
+		mapping = nullptr;
+	}
+	LARGE_INTEGER distance;
+	distance.QuadPart = newSize;
+	if (!SetFilePointerEx(file, distance, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) return false;
+	size = newSize;
+	return true;
+}
+
+bool ofxViveTrackerMappedFile::allocate(uint64_t newSize) {
+	if (newSize <= size) return true;
+	FILE_ALLOCATION_INFO allocation;
+	allocation.AllocationSize.QuadPart = newSize;
+	if (!SetFileInformationByHandle(file, FileAllocationInfo, &allocation, sizeof(allocation))) return false;
+	return resize(newSize);
+}
+
+void* ofxViveTrackerMappedFile::map(uint64_t offset, size_t length) {
+	if (!mapping) {
+		DWORD protect = mode == Mode::Write ? PAGE_READWRITE : PAGE_READONLY;
+		mapping = CreateFileMappingA(file, nullptr, protect, DWORD(size >> 32), DWORD(size), nullptr);
+		if (!mapping) return nullptr;
+	}
+	DWORD access = mode == Mode::Write ? FILE_MAP_WRITE : FILE_MAP_READ;
+	return MapViewOfFile(mapping, access, DWORD(offset >> 32), DWORD(offset), length);
+}
+
+void ofxViveTrackerMappedFile::unmap(void* data, size_t length) {
+	if (data) UnmapViewOfFile(data);
+}
+
+size_t ofxViveTrackerMappedFile::getGranularity() {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwAllocationGranularity;
+}
+
+#else
+
+ofxViveTrackerMappedFile::ofxViveTrackerMappedFile()
+	: mode(Mode::Read)
+	, size(0)
+	, fd(-1) {
+}
+
+ofxViveTrackerMappedFile::~ofxViveTrackerMappedFile() {
+	close();
+}
+
+bool ofxViveTrackerMappedFile::open(const std::string& path, Mode m) {
+	close();
+	mode = m;
+	if (mode == Mode::Write) {
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	} else {
+		fd = ::open(path.c_str(), O_RDONLY);
+	}
+	if (fd < 0) return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close();
+		return false;
+	}
+	size = info.st_size;
+	return true;
+}
+
+void ofxViveTrackerMappedFile::close() {
+	if (fd >= 0) {
+		::close(fd);
+		fd = -1;
+	}
+	size = 0;
+}
+
+bool ofxViveTrackerMappedFile::isOpen() const {
+	return fd >= 0;
+}
+
+bool ofxViveTrackerMappedFile::resize(uint64_t newSize) {
+	if (ftruncate(fd, newSize) != 0) return false;
+	size = newSize;
+	return true;
+}
+
+bool ofxViveTrackerMappedFile::allocate(uint64_t newSize) {
+	if (newSize <= size) return true;
+#ifndef __APPLE__
+	int error = posix_fallocate(fd, size, newSize - size);
+	if (error == 0) {
+		size = newSize;
+		return true;
+	}
+	// Only fall back where the file system can't preallocate
+	if (error != EINVAL && error != EOPNOTSUPP) return false;
+#endif
+	// Writing zeros allocates the blocks too
+	static const char zeros[65536] = {};
+	for (uint64_t offset = size; offset < newSize;) {
+		size_t length = size_t(std::min<uint64_t>(sizeof(zeros), newSize - offset));
+		ssize_t written = pwrite(fd, zeros, length, offset);
+		if (written < 0 && errno == EINTR) continue;
+		if (written <= 0) return false;
+		offset += written;
+	}
+	size = newSize;
+	return true;
+}
+
+void* ofxViveTrackerMappedFile::map(uint64_t offset, size_t length) {
+	int protect = mode == Mode::Write ? PROT_READ | PROT_WRITE : PROT_READ;
+	void* data = mmap(nullptr, length, protect, MAP_SHARED, fd, offset);
+	return data == MAP_FAILED ? nullptr : data;
+}
+
+void ofxViveTrackerMappedFile::unmap(void* data, size_t length) {
+	if (data) munmap(data, length);
+}
+
+size_t ofxViveTrackerMappedFile::getGranularity() {
+	return sysconf(_SC_PAGESIZE);
+}
+
+#endif
+
+uint64_t ofxViveTrackerMappedFile::getSize() const {
+	return size;
+}
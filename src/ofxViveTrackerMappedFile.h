@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Minimal memory-mapped file, POSIX mmap or Win32 file mappings.
+class ofxViveTrackerMappedFile {
+public:
+	enum class Mode {
+		Read,  // Existing file, read-only
+		Write  // Created or truncated, read-write
+	};
+
+	ofxViveTrackerMappedFile();
+	~ofxViveTrackerMappedFile();
+
+	bool open(const std::string& path, Mode mode);
+	void close();
+	bool isOpen() const;
+
+	uint64_t getSize() const;
+	// Views must be unmapped before shrinking the file. Growing may leave
+	// the new part sparse, see allocate().
+	bool resize(uint64_t size);
+	// Grows the file to size with disk blocks reserved for all of it, so
+	// that stores through a mapping can't fail later for lack of space
+	// (which would be a SIGBUS, not an error). False if the disk is full.
+	bool allocate(uint64_t size);
+
+	// offset must be a multiple of getGranularity().
+	void* map(uint64_t offset, size_t size);
+	void unmap(void* data, size_t size);
+
+	// Alignment for map() offsets: the page size on POSIX, the allocation
+	// granularity (usually 64KB) on Windows.
+	static size_t getGranularity();
+
+private:
+	Mode mode;
+	uint64_t size;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#else
+	int fd;
+#endif
+
+	ofxViveTrackerMappedFile(const ofxViveTrackerMappedFile&) = delete;
+	ofxViveTrackerMappedFile& operator=(const ofxViveTrackerMappedFile&) = delete;
+};
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "ofMain.h"
+#include <openvr.h>
+
+// Conversions between OpenVR's row-major 3x4 pose matrix and
+// quaternion + translation, and the small bits of rotation math built on
+// them.
+namespace ofxViveTrackerMath {
+
+	// Rotation straight from the 3x3 block, without building a mat4 first.
+	// Same branches and arithmetic as glm::quat_cast(): the largest of
+	// w, x, y and z is computed first and comes out positive, so results
+	// match it bit for bit, including the sign.
+	inline glm::quat toQuat(const vr::HmdMatrix34_t& mat) {
+		const float (*m)[4] = mat.m;
+		float fourX = m[0][0] - m[1][1] - m[2][2];
+		float fourY = m[1][1] - m[0][0] - m[2][2];
+		float fourZ = m[2][2] - m[0][0] - m[1][1];
+		float fourW = m[0][0] + m[1][1] + m[2][2];
+
+		int biggestIndex = 0;
+		float fourBiggest = fourW;
+		if (fourX > fourBiggest) {
+			fourBiggest = fourX;
+			biggestIndex = 1;
+		}
+		if (fourY > fourBiggest) {
+			fourBiggest = fourY;
+			biggestIndex = 2;
+		}
+		if (fourZ > fourBiggest) {
+			fourBiggest = fourZ;
+			biggestIndex = 3;
+		}
+
+		float big = std::sqrt(fourBiggest + 1.0f) * 0.5f;
+		float mult = 0.25f / big;
+		glm::quat q;
+		switch (biggestIndex) {
+		case 0:
+			q.w = big;
+			q.x = (m[2][1] - m[1][2]) * mult;
+			q.y = (m[0][2] - m[2][0]) * mult;
+			q.z = (m[1][0] - m[0][1]) * mult;
+			break;
+		case 1:
+			q.w = (m[2][1] - m[1][2]) * mult;
+			q.x = big;
+			q.y = (m[1][0] + m[0][1]) * mult;
+			q.z = (m[0][2] + m[2][0]) * mult;
+			break;
+		case 2:
+			q.w = (m[0][2] - m[2][0]) * mult;
+			q.x = (m[1][0] + m[0][1]) * mult;
+			q.y = big;
+			q.z = (m[2][1] + m[1][2]) * mult;
+			break;
+		default:
+			q.w = (m[1][0] - m[0][1]) * mult;
+			q.x = (m[0][2] + m[2][0]) * mult;
+			q.y = (m[2][1] + m[1][2]) * mult;
+			q.z = big;
+			break;
+		}
+		return q;
+	}
+
+	// Column-major 4x4 for openFrameworks.
+	inline glm::mat4 toMat4(const vr::HmdMatrix34_t& mat) {
+		return glm::mat4(
+			mat.m[0][0], mat.m[1][0], mat.m[2][0], 0.0f,
+			mat.m[0][1], mat.m[1][1], mat.m[2][1], 0.0f,
+			mat.m[0][2], mat.m[1][2], mat.m[2][2], 0.0f,
+			mat.m[0][3], mat.m[1][3], mat.m[2][3], 1.0f
+		);
+	}
+
+	inline glm::vec3 toPosition(const vr::HmdMatrix34_t& mat) {
+		return glm::vec3(mat.m[0][3], mat.m[1][3], mat.m[2][3]);
+	}
+
+	inline void toMatrix(const glm::quat& q, const glm::vec3& position, vr::HmdMatrix34_t& mat) {
+		float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+		float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+		float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+		float (*m)[4] = mat.m;
+		m[0][0] = 1.0f - 2.0f * (yy + zz);
+		m[0][1] = 2.0f * (xy - wz);
+		m[0][2] = 2.0f * (xz + wy);
+		m[1][0] = 2.0f * (xy + wz);
+		m[1][1] = 1.0f - 2.0f * (xx + zz);
+		m[1][2] = 2.0f * (yz - wx);
+		m[2][0] = 2.0f * (xz - wy);
+		m[2][1] = 2.0f * (yz + wx);
+		m[2][2] = 1.0f - 2.0f * (xx + yy);
+		m[0][3] = position.x;
+		m[1][3] = position.y;
+		m[2][3] = position.z;
+	}
+
+	// Inverse of toMat4(), dropping the bottom row.
+	inline void toMatrix(const glm::mat4& m, vr::HmdMatrix34_t& mat) {
+		for (int row = 0; row < 3; row++) {
+			for (int col = 0; col < 4; col++) {
+				mat.m[row][col] = m[col][row];
+			}
+		}
+	}
+
+	// a * b as affine transforms. out must not alias a or b.
+	inline void multiply(const vr::HmdMatrix34_t& a, const vr::HmdMatrix34_t& b, vr::HmdMatrix34_t& out) {
+		for (int row = 0; row < 3; row++) {
+			const float* r = a.m[row];
+			for (int col = 0; col < 4; col++) {
+				out.m[row][col] = r[0] * b.m[0][col] + r[1] * b.m[1][col] + r[2] * b.m[2][col];
+			}
+			out.m[row][3] += r[3];
+		}
+	}
+
+	// The 3x3 block of mat applied to v.
+	inline glm::vec3 rotate(const vr::HmdMatrix34_t& mat, const glm::vec3& v) {
+		const float (*m)[4] = mat.m;
+		return glm::vec3(
+			m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+			m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+			m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+	}
+
+	inline glm::mat4 toMat4(const glm::quat& q, const glm::vec3& position) {
+		vr::HmdMatrix34_t mat;
+		toMatrix(q, position, mat);
+		return toMat4(mat);
+	}
+
+	// Rotation by a rotation vector (axis times angle)
+	inline glm::quat fromRotationVector(const glm::vec3& v) {
+		float angle = glm::length(v);
+		if (angle < 1e-9f) {
+			return glm::quat(1.0f, 0.5f * v.x, 0.5f * v.y, 0.5f * v.z);
+		}
+		float s = std::sin(0.5f * angle) / angle;
+		return glm::quat(std::cos(0.5f * angle), v.x * s, v.y * s, v.z * s);
+	}
+
+	// Rotation vector of a unit quaternion, the short way around
+	inline glm::vec3 toRotationVector(glm::quat q) {
+		if (q.w < 0.0f) {
+			q = -q;
+		}
+		glm::vec3 v(q.x, q.y, q.z);
+		float s = glm::length(v);
+		if (s < 1e-9f) {
+			return 2.0f * v;
+		}
+		return v * (2.0f * std::atan2(s, q.w) / s);
+	}
+}
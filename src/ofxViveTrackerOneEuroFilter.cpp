@@ -0,0 +1,174 @@
+#include "ofxViveTrackerOneEuroFilter.h"
+#include "ofxViveTrackerSimd.h"
+
+using namespace ofxViveTrackerSimd;
+
+ofxViveTrackerOneEuroFilter::ofxViveTrackerOneEuroFilter() {
+	// A millimeter of jitter at rest is gone at 1Hz; at 1m/s the cutoff is
+	// already 21Hz, and 6Hz at 1 radian per second
+	setPositionParameters(Parameters(1.0f, 20.0f, 1.0f));
+	setOrientationParameters(Parameters(1.0f, 5.0f, 1.0f));
+	reset();
+}
+
+void ofxViveTrackerOneEuroFilter::setPositionParameters(const Parameters& parameters) {
+	for (size_t slot = 0; slot < maxTrackers; slot++) {
+		setPositionParameters(slot, parameters);
+	}
+}
+
+void ofxViveTrackerOneEuroFilter::setPositionParameters(size_t slot, const Parameters& parameters) {
+	if (slot >= maxTrackers) return;
+	positionMinCutoff[slot] = parameters.minCutoff;
+	positionBeta[slot] = parameters.beta;
+	positionDerivativeCutoff[slot] = parameters.derivativeCutoff;
+}
+
+void ofxViveTrackerOneEuroFilter::setOrientationParameters(const Parameters& parameters) {
+	for (size_t slot = 0; slot < maxTrackers; slot++) {
+		setOrientationParameters(slot, parameters);
+	}
+}
+
+void ofxViveTrackerOneEuroFilter::setOrientationParameters(size_t slot, const Parameters& parameters) {
+	if (slot >= maxTrackers) return;
+	orientationMinCutoff[slot] = parameters.minCutoff;
+	orientationBeta[slot] = parameters.beta;
+	orientationDerivativeCutoff[slot] = parameters.derivativeCutoff;
+}
+
+ofxViveTrackerOneEuroFilter::Parameters ofxViveTrackerOneEuroFilter::getPositionParameters(size_t slot) const {
+	return Parameters(positionMinCutoff[slot], positionBeta[slot], positionDerivativeCutoff[slot]);
+}
+
+ofxViveTrackerOneEuroFilter::Parameters ofxViveTrackerOneEuroFilter::getOrientationParameters(size_t slot) const {
+	return Parameters(orientationMinCutoff[slot], orientationBeta[slot], orientationDerivativeCutoff[slot]);
+}
+
+void ofxViveTrackerOneEuroFilter::reset() {
+	for (size_t slot = 0; slot < maxTrackers; slot++) {
+		reset(slot);
+	}
+}
+
+void ofxViveTrackerOneEuroFilter::reset(size_t slot) {
+	if (slot >= maxTrackers) return;
+	initialized[slot] = false;
+	inX[slot] = inY[slot] = inZ[slot] = 0.0f;
+	inQX[slot] = inQY[slot] = inQZ[slot] = 0.0f;
+	inQW[slot] = 1.0f;
+	dt[slot] = 0.0f;
+	x[slot] = y[slot] = z[slot] = 0.0f;
+	dx[slot] = dy[slot] = dz[slot] = 0.0f;
+	qx[slot] = qy[slot] = qz[slot] = 0.0f;
+	qw[slot] = 1.0f;
+	rate[slot] = 0.0f;
+}
+
+void ofxViveTrackerOneEuroFilter::setInput(size_t slot, const glm::vec3& position, const glm::quat& orientation, std::chrono::steady_clock::time_point time) {
+	if (slot >= maxTrackers) return;
+	inX[slot] = position.x;
+	inY[slot] = position.y;
+	inZ[slot] = position.z;
+	inQX[slot] = orientation.x;
+	inQY[slot] = orientation.y;
+	inQZ[slot] = orientation.z;
+	inQW[slot] = orientation.w;
+
+	if (!initialized[slot]) {
+		// First pose starts the filter where the tracker is
+		x[slot] = position.x;
+		y[slot] = position.y;
+		z[slot] = position.z;
+		qx[slot] = orientation.x;
+		qy[slot] = orientation.y;
+		qz[slot] = orientation.z;
+		qw[slot] = orientation.w;
+		dt[slot] = 0.0f;
+		initialized[slot] = true;
+	} else {
+		dt[slot] = std::chrono::duration<float>(time - lastTime[slot]).count();
+	}
+	lastTime[slot] = time;
+}
+
+void ofxViveTrackerOneEuroFilter::apply(size_t count) {
+	count = std::min<size_t>(count, maxTrackers);
+	const Float4 zero(0.0f);
+	const Float4 one(1.0f);
+	const Float4 twoPi(TWO_PI);
+
+	for (size_t i = 0; i < count; i += 4) {
+		Float4 elapsed = Float4::load(dt + i);
+		Float4 active = elapsed > zero;
+		if (!any(active)) continue;
+		Float4 safeElapsed = select(active, elapsed, one);
+
+		// Smoothing factor of a first order low-pass at this cutoff
+		auto alpha = [&](Float4 cutoff) {
+			Float4 r = twoPi * cutoff * safeElapsed;
+			return r / (r + one);
+		};
+
+		// Position: filter the velocity, then the position with a cutoff
+		// that follows the filtered speed
+		Float4 px = Float4::load(x + i), py = Float4::load(y + i), pz = Float4::load(z + i);
+		Float4 ix = Float4::load(inX + i), iy = Float4::load(inY + i), iz = Float4::load(inZ + i);
+		Float4 vx = Float4::load(dx + i), vy = Float4::load(dy + i), vz = Float4::load(dz + i);
+		Float4 a = alpha(Float4::load(positionDerivativeCutoff + i));
+		vx = vx + a * ((ix - px) / safeElapsed - vx);
+		vy = vy + a * ((iy - py) / safeElapsed - vy);
+		vz = vz + a * ((iz - pz) / safeElapsed - vz);
+		Float4 speed = sqrt(vx * vx + vy * vy + vz * vz);
+		a = alpha(Float4::load(positionMinCutoff + i) + Float4::load(positionBeta + i) * speed);
+		select(active, px + a * (ix - px), px).store(x + i);
+		select(active, py + a * (iy - py), py).store(y + i);
+		select(active, pz + a * (iz - pz), pz).store(z + i);
+		select(active, vx, Float4::load(dx + i)).store(dx + i);
+		select(active, vy, Float4::load(dy + i)).store(dy + i);
+		select(active, vz, Float4::load(dz + i)).store(dz + i);
+
+		// Orientation: move the input into the filtered quaternion's
+		// hemisphere, take the rotation rate from the angle between them
+		// (2 sin(angle / 2), accurate for per-sample rotations) and blend
+		Float4 fx = Float4::load(qx + i), fy = Float4::load(qy + i), fz = Float4::load(qz + i), fw = Float4::load(qw + i);
+		Float4 jx = Float4::load(inQX + i), jy = Float4::load(inQY + i), jz = Float4::load(inQZ + i), jw = Float4::load(inQW + i);
+		Float4 dot = fx * jx + fy * jy + fz * jz + fw * jw;
+		Float4 flip = signBit(dot);
+		jx = jx ^ flip;
+		jy = jy ^ flip;
+		jz = jz ^ flip;
+		jw = jw ^ flip;
+		dot = abs(dot);
+		Float4 angle = Float4(2.0f) * sqrt(maximum(zero, one - dot * dot));
+		Float4 r = Float4::load(rate + i);
+		a = alpha(Float4::load(orientationDerivativeCutoff + i));
+		r = r + a * (angle / safeElapsed - r);
+		a = alpha(Float4::load(orientationMinCutoff + i) + Float4::load(orientationBeta + i) * r);
+		Float4 nx = fx + a * (jx - fx);
+		Float4 ny = fy + a * (jy - fy);
+		Float4 nz = fz + a * (jz - fz);
+		Float4 nw = fw + a * (jw - fw);
+		Float4 length = sqrt(nx * nx + ny * ny + nz * nz + nw * nw);
+		select(active, nx / length, fx).store(qx + i);
+		select(active, ny / length, fy).store(qy + i);
+		select(active, nz / length, fz).store(qz + i);
+		select(active, nw / length, fw).store(qw + i);
+		select(active, r, Float4::load(rate + i)).store(rate + i);
+
+		zero.store(dt + i);
+	}
+}
+
+glm::vec3 ofxViveTrackerOneEuroFilter::getPosition(size_t slot) const {
+	return glm::vec3(x[slot], y[slot], z[slot]);
+}
+
+glm::quat ofxViveTrackerOneEuroFilter::getOrientation(size_t slot) const {
+	glm::quat q;
+	q.x = qx[slot];
+	q.y = qy[slot];
+	q.z = qz[slot];
+	q.w = qw[slot];
+	return q;
+}
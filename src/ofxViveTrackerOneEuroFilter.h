@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ofMain.h"
+#include <openvr.h>
+#include <chrono>
+
+// One Euro filter (Casiez et al. 2012) for every tracker at once: an
+// adaptive low-pass whose cutoff rises with speed, so trackers at rest lose
+// their jitter while fast motion keeps its latency low.
+//
+// State is stored as structure-of-arrays, one lane per slot, and apply()
+// filters four trackers per instruction. Orientation uses the same scheme
+// on the rotation rate between filtered and new orientation, blending
+// quaternions with a normalized lerp.
+class ofxViveTrackerOneEuroFilter {
+public:
+	struct Parameters {
+		float minCutoff;        // Hz, cutoff at rest: lower is smoother
+		float beta;             // Cutoff increase per unit of speed: higher is less lag
+		float derivativeCutoff; // Hz, smoothing of the speed estimate
+
+		Parameters(float minCutoff = 1.0f, float beta = 0.0f, float derivativeCutoff = 1.0f)
+			: minCutoff(minCutoff)
+			, beta(beta)
+			, derivativeCutoff(derivativeCutoff) {
+		}
+	};
+
+	enum {
+		maxTrackers = vr::k_unMaxTrackedDeviceCount
+	};
+
+	ofxViveTrackerOneEuroFilter();
+
+	// Speed is in meters per second for position and radians per second for
+	// orientation. The defaults suit handheld and body-worn trackers.
+	void setPositionParameters(const Parameters& parameters);
+	void setPositionParameters(size_t slot, const Parameters& parameters);
+	void setOrientationParameters(const Parameters& parameters);
+	void setOrientationParameters(size_t slot, const Parameters& parameters);
+	Parameters getPositionParameters(size_t slot) const;
+	Parameters getOrientationParameters(size_t slot) const;
+
+	// The next input of the slot passes through unfiltered.
+	void reset();
+	void reset(size_t slot);
+
+	// Queue a new pose for a slot, then filter all queued poses with apply().
+	void setInput(size_t slot, const glm::vec3& position, const glm::quat& orientation, std::chrono::steady_clock::time_point time);
+	// Filters slots [0, count).
+	void apply(size_t count);
+
+	glm::vec3 getPosition(size_t slot) const;
+	glm::quat getOrientation(size_t slot) const;
+
+private:
+	// Inputs, seconds since the previous input (0: nothing queued)
+	alignas(16) float inX[maxTrackers], inY[maxTrackers], inZ[maxTrackers];
+	alignas(16) float inQX[maxTrackers], inQY[maxTrackers], inQZ[maxTrackers], inQW[maxTrackers];
+	alignas(16) float dt[maxTrackers];
+
+	// Filtered values and derivatives
+	alignas(16) float x[maxTrackers], y[maxTrackers], z[maxTrackers];
+	alignas(16) float dx[maxTrackers], dy[maxTrackers], dz[maxTrackers];
+	alignas(16) float qx[maxTrackers], qy[maxTrackers], qz[maxTrackers], qw[maxTrackers];
+	alignas(16) float rate[maxTrackers];
+
+	alignas(16) float positionMinCutoff[maxTrackers], positionBeta[maxTrackers], positionDerivativeCutoff[maxTrackers];
+	alignas(16) float orientationMinCutoff[maxTrackers], orientationBeta[maxTrackers], orientationDerivativeCutoff[maxTrackers];
+
+	std::chrono::steady_clock::time_point lastTime[maxTrackers];
+	bool initialized[maxTrackers];
+};
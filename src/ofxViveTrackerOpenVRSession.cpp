@@ -0,0 +1,268 @@
+#include "ofxViveTrackerOpenVRSession.h"
+#include <algorithm>
+#include <cstring>
+
+// Built without OpenVR along with ofxViveTrackerOpenVRSource.
+#ifndef OFXVIVETRACKER_NO_OPENVR
+
+ofxViveTrackerOpenVRSession& ofxViveTrackerOpenVRSession::get() {
+	static ofxViveTrackerOpenVRSession session;
+	return session;
+}
+
+ofxViveTrackerOpenVRSession::ofxViveTrackerOpenVRSession()
+	: system(nullptr)
+	, changing(false)
+	, quitting(false)
+	, nextUser(0)
+	, tolerance(std::chrono::milliseconds(1))
+	, haveSnapshot(false)
+	, snapshotGeneration(0)
+	, snapshotOrigin(vr::TrackingUniverseStanding)
+	, fetches(0)
+	, reuses(0) {
+}
+
+int ofxViveTrackerOpenVRSession::acquire() {
+	// Users that never got to the Quit shouldn't keep everyone else out
+	shutDownIfDone();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	condition.wait(lock, [this] { return !changing; });
+	if (quitting) return -1;
+	if (!system) {
+		// Nobody else can use the session yet, so this needn't hold the lock
+		changing = true;
+		lock.unlock();
+		vr::EVRInitError err = vr::VRInitError_None;
+		vr::IVRSystem* vrSystem = vr::VR_Init(&err, vr::VRApplication_Background);
+		lock.lock();
+		changing = false;
+		condition.notify_all();
+		if (err != vr::VRInitError_None || !vrSystem) {
+			return -1;
+		}
+		system = vrSystem;
+		haveSnapshot = false;
+	}
+	int user = nextUser++;
+	users[user];
+	return user;
+}
+
+void ofxViveTrackerOpenVRSession::release(int user) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!users.erase(user)) return;
+	}
+	shutDownIfDone();
+}
+
+size_t ofxViveTrackerOpenVRSession::getNumUsers() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::count_if(users.begin(), users.end(), [](const std::pair<const int, User>& user) {
+		return !user.second.expired;
+	});
+}
+
+bool ofxViveTrackerOpenVRSession::isDone() const {
+	if (!system || changing) return false;
+	bool allSawQuit = true;
+	bool anyUsers = false;
+	for (auto& user : users) {
+		if (user.second.expired) continue;
+		anyUsers = true;
+		allSawQuit = allSawQuit && user.second.sawQuit;
+	}
+	if (!anyUsers) return true;
+	if (!quitting) return false;
+	return allSawQuit || std::chrono::steady_clock::now() - quitTime >= std::chrono::duration<float>(quitTimeout);
+}
+
+void ofxViveTrackerOpenVRSession::shutDownIfDone() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!isDone()) return;
+	}
+
+	// Waits for IVRSystem calls in flight; new ones find no system
+	std::unique_lock<std::shared_timed_mutex> systemLock(systemMutex);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!isDone()) return;
+		changing = true;
+		system = nullptr;
+		quitting = false;
+		haveSnapshot = false;
+		for (auto& user : users) {
+			User& state = user.second;
+			state.expired = true;
+			state.events.clear();
+			if (!state.sawQuit) {
+				// So it ends its session when it gets around to polling
+				vr::VREvent_t event;
+				memset(&event, 0, sizeof(event));
+				event.eventType = vr::VREvent_Quit;
+				event.trackedDeviceIndex = vr::k_unTrackedDeviceIndexInvalid;
+				state.events.push_back(event);
+				state.sawQuit = true;
+			}
+		}
+	}
+	vr::VR_Shutdown();
+	systemLock.unlock();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		changing = false;
+	}
+	condition.notify_all();
+}
+
+vr::IVRSystem* ofxViveTrackerOpenVRSession::getSystem(int user) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = users.find(user);
+	if (it == users.end() || it->second.expired) return nullptr;
+	return system;
+}
+
+bool ofxViveTrackerOpenVRSession::isDeviceConnected(int user, vr::TrackedDeviceIndex_t index) {
+	std::shared_lock<std::shared_timed_mutex> systemLock(systemMutex);
+	vr::IVRSystem* vrSystem = getSystem(user);
+	return vrSystem && vrSystem->IsTrackedDeviceConnected(index);
+}
+
+vr::ETrackedDeviceClass ofxViveTrackerOpenVRSession::getDeviceClass(int user, vr::TrackedDeviceIndex_t index) {
+	std::shared_lock<std::shared_timed_mutex> systemLock(systemMutex);
+	vr::IVRSystem* vrSystem = getSystem(user);
+	if (!vrSystem) return vr::TrackedDeviceClass_Invalid;
+	return vrSystem->GetTrackedDeviceClass(index);
+}
+
+std::string ofxViveTrackerOpenVRSession::getStringProperty(int user, vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop) {
+	std::shared_lock<std::shared_timed_mutex> systemLock(systemMutex);
+	vr::IVRSystem* vrSystem = getSystem(user);
+	if (!vrSystem) return "";
+	char buffer[vr::k_unMaxPropertyStringSize];
+	vr::ETrackedPropertyError err = vr::TrackedProp_Success;
+	vrSystem->GetStringTrackedDeviceProperty(index, prop, buffer, sizeof(buffer), &err);
+	if (err != vr::TrackedProp_Success) return "";
+	return buffer;
+}
+
+bool ofxViveTrackerOpenVRSession::getFloatProperty(int user, vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop, float& value) {
+	std::shared_lock<std::shared_timed_mutex> systemLock(systemMutex);
+	vr::IVRSystem* vrSystem = getSystem(user);
+	if (!vrSystem) return false;
+	vr::ETrackedPropertyError err = vr::TrackedProp_Success;
+	value = vrSystem->GetFloatTrackedDeviceProperty(index, prop, &err);
+	return err == vr::TrackedProp_Success;
+}
+
+bool ofxViveTrackerOpenVRSession::getTimeSinceLastVsync(int user, float& secondsSinceVsync, uint64_t& frame) {
+	std::shared_lock<std::shared_timed_mutex> systemLock(systemMutex);
+	vr::IVRSystem* vrSystem = getSystem(user);
+	return vrSystem && vrSystem->GetTimeSinceLastVsync(&secondsSinceVsync, &frame);
+}
+
+void ofxViveTrackerOpenVRSession::pumpEvents() {
+	vr::VREvent_t event;
+	while (system->PollNextEvent(&event, sizeof(event))) {
+		if (event.eventType == vr::VREvent_Quit && !quitting) {
+			// No new users until it shut down
+			quitting = true;
+			quitTime = std::chrono::steady_clock::now();
+		}
+		for (auto& user : users) {
+			if (user.second.expired) continue;
+			auto& events = user.second.events;
+			if (events.size() >= maxQueuedEvents) {
+				events.pop_front();
+			}
+			events.push_back(event);
+		}
+	}
+}
+
+bool ofxViveTrackerOpenVRSession::pollNextEvent(int user, vr::VREvent_t& event) {
+	bool sawQuit = false;
+	{
+		std::shared_lock<std::shared_timed_mutex> systemLock(systemMutex);
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = users.find(user);
+		if (it == users.end()) return false;
+		User& state = it->second;
+		if (state.events.empty() && !state.expired && system) {
+			pumpEvents();
+		}
+		if (state.events.empty()) return false;
+		event = state.events.front();
+		state.events.pop_front();
+		if (event.eventType == vr::VREvent_Quit && !state.expired) {
+			state.sawQuit = true;
+			sawQuit = true;
+		}
+	}
+	if (sawQuit) {
+		// The last one to see it shuts the session down
+		shutDownIfDone();
+	}
+	return true;
+}
+
+void ofxViveTrackerOpenVRSession::getPoses(int user, vr::ETrackingUniverseOrigin origin, float predictedSeconds, vr::TrackedDevicePose_t* poses, uint32_t count, std::chrono::steady_clock::time_point& fetchTime) {
+	count = std::min<uint32_t>(count, vr::k_unMaxTrackedDeviceCount);
+	auto now = std::chrono::steady_clock::now();
+	auto target = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(predictedSeconds));
+
+	std::shared_lock<std::shared_timed_mutex> systemLock(systemMutex);
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = users.find(user);
+	if (!system || it == users.end() || it->second.expired) {
+		// Everything disconnected
+		memset(poses, 0, count * sizeof(vr::TrackedDevicePose_t));
+		fetchTime = now;
+		return;
+	}
+	// Never a snapshot the user already had, which would duplicate its samples
+	User& state = it->second;
+	bool reuse = haveSnapshot && state.lastSnapshot != snapshotGeneration && snapshotOrigin == origin
+		&& now - snapshotTime <= tolerance
+		&& target - snapshotTarget <= tolerance && snapshotTarget - target <= tolerance;
+	if (reuse) {
+		reuses++;
+	} else {
+		system->GetDeviceToAbsoluteTrackingPose(origin, predictedSeconds, snapshot, vr::k_unMaxTrackedDeviceCount);
+		haveSnapshot = true;
+		snapshotGeneration++;
+		snapshotOrigin = origin;
+		snapshotTime = now;
+		snapshotTarget = target;
+		fetches++;
+	}
+	state.lastSnapshot = snapshotGeneration;
+	fetchTime = snapshotTime;
+	memcpy(poses, snapshot, count * sizeof(vr::TrackedDevicePose_t));
+}
+
+void ofxViveTrackerOpenVRSession::setSnapshotTolerance(float seconds) {
+	std::lock_guard<std::mutex> lock(mutex);
+	tolerance = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(std::max(seconds, 0.0f)));
+}
+
+float ofxViveTrackerOpenVRSession::getSnapshotTolerance() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::chrono::duration<float>(tolerance).count();
+}
+
+uint64_t ofxViveTrackerOpenVRSession::getNumFetches() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return fetches;
+}
+
+uint64_t ofxViveTrackerOpenVRSession::getNumReuses() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return reuses;
+}
+
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <openvr.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// The process's OpenVR session, shared by every ofxViveTrackerOpenVRSource
+// so several ofxViveTracker instances can run side by side. VR_Init
+// happens when the first user joins and VR_Shutdown when the last leaves.
+//
+// OpenVR has one event queue per process, so the session drains it into a
+// queue per user and every user sees every event. The last pose fetch is
+// kept as a snapshot that the other users reuse, once each, when they ask
+// for the same universe and instant, so instances updated together cost one
+// fetch.
+//
+// VR_Init and VR_Shutdown run without holding the lock the other calls
+// take, so starting SteamVR never stalls users of a running session. After
+// SteamVR quits, the session shuts down once every user has seen the Quit,
+// or after quitTimeout for users that stopped polling. Those keep their id
+// until they release it, get a Quit event of their own, and from then on
+// only see disconnected devices. Everything is thread safe.
+class ofxViveTrackerOpenVRSession {
+public:
+	// Events kept per user before the oldest are dropped
+	static constexpr size_t maxQueuedEvents = 1024;
+	// Seconds users get to see a Quit before the session shuts down anyway
+	static constexpr float quitTimeout = 2.0f;
+
+	static ofxViveTrackerOpenVRSession& get();
+
+	// Joins the session, starting it if this is the first user; may block
+	// while SteamVR starts. Returns a user id, or -1 if OpenVR didn't start
+	// or the session is still winding down after SteamVR quit.
+	int acquire();
+	void release(int user);
+	// Users of the running session, not counting those it shut down under.
+	size_t getNumUsers() const;
+
+	// IVRSystem calls on behalf of a user; defaults once the session is gone.
+	bool isDeviceConnected(int user, vr::TrackedDeviceIndex_t index);
+	vr::ETrackedDeviceClass getDeviceClass(int user, vr::TrackedDeviceIndex_t index);
+	std::string getStringProperty(int user, vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop);
+	bool getFloatProperty(int user, vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop, float& value);
+	bool getTimeSinceLastVsync(int user, float& secondsSinceVsync, uint64_t& frame);
+
+	bool pollNextEvent(int user, vr::VREvent_t& event);
+
+	// Reuses another user's snapshot if it was fetched for the same
+	// universe, for an instant within the tolerance of this one, no longer
+	// than the tolerance ago, and this user hasn't had it yet. Default 1ms.
+	// fetchTime is when the poses were fetched, earlier than the call for a
+	// reused snapshot.
+	void getPoses(int user, vr::ETrackingUniverseOrigin origin, float predictedSeconds, vr::TrackedDevicePose_t* poses, uint32_t count, std::chrono::steady_clock::time_point& fetchTime);
+	void setSnapshotTolerance(float seconds);
+	float getSnapshotTolerance() const;
+	// GetDeviceToAbsoluteTrackingPose() calls and snapshot reuses so far.
+	uint64_t getNumFetches() const;
+	uint64_t getNumReuses() const;
+
+private:
+	struct User {
+		std::deque<vr::VREvent_t> events;
+		bool sawQuit = false;
+		// Still holding an id after the session shut down
+		bool expired = false;
+		// Generation of the last snapshot this user got
+		uint64_t lastSnapshot = 0;
+	};
+
+	ofxViveTrackerOpenVRSession();
+	void pumpEvents();
+	// The system if the user belongs to the running session. Call with
+	// systemMutex held, which keeps it alive.
+	vr::IVRSystem* getSystem(int user) const;
+	// Shuts down if nobody is left, or everyone saw the Quit or had the time to
+	void shutDownIfDone();
+	bool isDone() const;
+
+	// Held shared around IVRSystem calls and exclusively to shut it down;
+	// always taken before mutex
+	mutable std::shared_timed_mutex systemMutex;
+	mutable std::mutex mutex;
+	// Signalled when VR_Init or VR_Shutdown finishes
+	std::condition_variable condition;
+	vr::IVRSystem* system;
+	// VR_Init or VR_Shutdown in progress
+	bool changing;
+	bool quitting;
+	std::chrono::steady_clock::time_point quitTime;
+	int nextUser;
+	std::unordered_map<int, User> users;
+
+	std::chrono::steady_clock::duration tolerance;
+	bool haveSnapshot;
+	// Bumped on every fetch
+	uint64_t snapshotGeneration;
+	vr::ETrackingUniverseOrigin snapshotOrigin;
+	std::chrono::steady_clock::time_point snapshotTime;
+	std::chrono::steady_clock::time_point snapshotTarget;
+	vr::TrackedDevicePose_t snapshot[vr::k_unMaxTrackedDeviceCount];
+	uint64_t fetches;
+	uint64_t reuses;
+};
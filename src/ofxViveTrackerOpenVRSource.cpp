@@ -0,0 +1,62 @@
+#include "ofxViveTrackerOpenVRSource.h"
+#include "ofxViveTrackerOpenVRSession.h"
+
+// Define OFXVIVETRACKER_NO_OPENVR to build without linking openvr_api, for
+// example on headless machines that only use the synthetic or replay sources.
+#ifndef OFXVIVETRACKER_NO_OPENVR
+
+ofxViveTrackerOpenVRSource::ofxViveTrackerOpenVRSource()
+	: user(-1) {
+}
+
+ofxViveTrackerOpenVRSource::~ofxViveTrackerOpenVRSource() {
+	disconnect();
+}
+
+bool ofxViveTrackerOpenVRSource::connect() {
+	user = ofxViveTrackerOpenVRSession::get().acquire();
+	return user >= 0;
+}
+
+void ofxViveTrackerOpenVRSource::disconnect() {
+	if (user >= 0) {
+		ofxViveTrackerOpenVRSession::get().release(user);
+		user = -1;
+	}
+}
+
+bool ofxViveTrackerOpenVRSource::isDeviceConnected(vr::TrackedDeviceIndex_t index) {
+	return ofxViveTrackerOpenVRSession::get().isDeviceConnected(user, index);
+}
+
+vr::ETrackedDeviceClass ofxViveTrackerOpenVRSource::getDeviceClass(vr::TrackedDeviceIndex_t index) {
+	return ofxViveTrackerOpenVRSession::get().getDeviceClass(user, index);
+}
+
+std::string ofxViveTrackerOpenVRSource::getStringProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop) {
+	return ofxViveTrackerOpenVRSession::get().getStringProperty(user, index, prop);
+}
+
+bool ofxViveTrackerOpenVRSource::getFloatProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop, float& value) {
+	return ofxViveTrackerOpenVRSession::get().getFloatProperty(user, index, prop, value);
+}
+
+bool ofxViveTrackerOpenVRSource::pollNextEvent(vr::VREvent_t& event) {
+	return ofxViveTrackerOpenVRSession::get().pollNextEvent(user, event);
+}
+
+bool ofxViveTrackerOpenVRSource::getTimeSinceLastVsync(float& secondsSinceVsync, uint64_t& frame) {
+	return ofxViveTrackerOpenVRSession::get().getTimeSinceLastVsync(user, secondsSinceVsync, frame);
+}
+
+void ofxViveTrackerOpenVRSource::getPoses(vr::ETrackingUniverseOrigin origin, float predictedSeconds, vr::TrackedDevicePose_t* poses, uint32_t count) {
+	ofxViveTrackerOpenVRSession::get().getPoses(user, origin, predictedSeconds, poses, count, fetchTime);
+}
+
+bool ofxViveTrackerOpenVRSource::getPosesFetchTime(std::chrono::steady_clock::time_point& time) {
+	// Earlier than the call when another user's snapshot was reused
+	time = fetchTime;
+	return true;
+}
+
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ofxViveTrackerSource.h"
+
+// The real thing: a user of the process's shared background OpenVR
+// session (ofxViveTrackerOpenVRSession).
+class ofxViveTrackerOpenVRSource : public ofxViveTrackerSource {
+public:
+	ofxViveTrackerOpenVRSource();
+	~ofxViveTrackerOpenVRSource();
+
+	bool connect() override;
+	void disconnect() override;
+
+	bool isDeviceConnected(vr::TrackedDeviceIndex_t index) override;
+	vr::ETrackedDeviceClass getDeviceClass(vr::TrackedDeviceIndex_t index) override;
+	std::string getStringProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop) override;
+	bool getFloatProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop, float& value) override;
+
+	bool pollNextEvent(vr::VREvent_t& event) override;
+	bool getTimeSinceLastVsync(float& secondsSinceVsync, uint64_t& frame) override;
+	void getPoses(vr::ETrackingUniverseOrigin origin, float predictedSeconds, vr::TrackedDevicePose_t* poses, uint32_t count) override;
+	bool getPosesFetchTime(std::chrono::steady_clock::time_point& time) override;
+
+private:
+	int user;
+	std::chrono::steady_clock::time_point fetchTime;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxViveTrackerMath.h"
+#include <openvr.h>
+#include <chrono>
+
+// One complete pose sample. Trivially copyable so it can be published
+// between threads with ofxViveTrackerSeqLock.
+struct ofxViveTrackerPose {
+	bool tracking;
+
+	// Instant the pose describes (the fetch time plus any prediction
+	// horizon) and the OpenVR frame counter when it was fetched.
+	std::chrono::steady_clock::time_point time;
+	uint64_t frame;
+
+	glm::vec3 position;
+	glm::quat orientation;
+	glm::mat4 matrix;
+	glm::vec3 velocity;
+	glm::vec3 angularVelocity;
+	// Only estimated by the constant acceleration Kalman filter, else zero
+	glm::vec3 acceleration;
+
+	ofxViveTrackerPose()
+		: tracking(false)
+		, frame(0)
+		, position(0.0f)
+		, orientation(1.0f, 0.0f, 0.0f, 0.0f)
+		, matrix(1.0f)
+		, velocity(0.0f)
+		, angularVelocity(0.0f)
+		, acceleration(0.0f) {
+	}
+};
+
+// A pose as stored and published by the trackers: OpenVR's 3x4 matrix and
+// the derivatives, from which position is a read and orientation and mat4
+// are computed only when asked for.
+struct ofxViveTrackerRawPose {
+	bool tracking;
+	// As OpenVR reported it, e.g. Running_OutOfRange while tracking is lost
+	vr::ETrackingResult trackingResult;
+	std::chrono::steady_clock::time_point time;
+	uint64_t frame;
+	// Changes with every new pose of a slot, to key caches of derived values
+	uint64_t sample;
+
+	vr::HmdMatrix34_t matrix;
+	glm::vec3 velocity;
+	glm::vec3 angularVelocity;
+	glm::vec3 acceleration;
+
+	ofxViveTrackerRawPose()
+		: tracking(false)
+		, trackingResult(vr::TrackingResult_Uninitialized)
+		, frame(0)
+		, sample(0)
+		, velocity(0.0f)
+		, angularVelocity(0.0f)
+		, acceleration(0.0f) {
+		ofxViveTrackerMath::toMatrix(glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.0f), matrix);
+	}
+
+	glm::vec3 getPosition() const {
+		return ofxViveTrackerMath::toPosition(matrix);
+	}
+
+	ofxViveTrackerPose toPose() const {
+		ofxViveTrackerPose pose;
+		pose.tracking = tracking;
+		pose.time = time;
+		pose.frame = frame;
+		pose.position = getPosition();
+		pose.orientation = ofxViveTrackerMath::toQuat(matrix);
+		pose.matrix = ofxViveTrackerMath::toMat4(matrix);
+		pose.velocity = velocity;
+		pose.angularVelocity = angularVelocity;
+		pose.acceleration = acceleration;
+		return pose;
+	}
+};
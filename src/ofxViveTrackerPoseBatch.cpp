@@ -0,0 +1,130 @@
+#include "ofxViveTrackerPoseBatch.h"
+#include "ofxViveTrackerSimd.h"
+
+using namespace ofxViveTrackerSimd;
+
+ofxViveTrackerPoseBatch::ofxViveTrackerPoseBatch()
+	: count(0)
+	, validMask(0) {
+}
+
+void ofxViveTrackerPoseBatch::convert(const vr::TrackedDevicePose_t* poses, size_t n, bool writeMatrices) {
+	count = std::min<size_t>(n, maxDevices);
+	validMask = 0;
+
+	const Float4 zero(0.0f);
+	const Float4 one(1.0f);
+	const Float4 half(0.5f);
+	const Float4 quarter(0.25f);
+	const Float4 all = one > zero;
+	const float zeroRow[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	for (size_t i = 0; i < count; i++) {
+		if (poses[i].bDeviceIsConnected && poses[i].bPoseIsValid) {
+			validMask |= uint64_t(1) << i;
+		}
+	}
+
+	for (size_t i = 0; i < count; i += 4) {
+		// Rows of four matrices, padding a short last group with zeros
+		const float* rows[4][3];
+		for (size_t lane = 0; lane < 4; lane++) {
+			const vr::HmdMatrix34_t& mat = poses[std::min(i + lane, count - 1)].mDeviceToAbsoluteTracking;
+			bool inside = i + lane < count;
+			rows[lane][0] = inside ? mat.m[0] : zeroRow;
+			rows[lane][1] = inside ? mat.m[1] : zeroRow;
+			rows[lane][2] = inside ? mat.m[2] : zeroRow;
+		}
+
+		Float4 m[3][4];
+		for (int row = 0; row < 3; row++) {
+			m[row][0] = Float4::loadUnaligned(rows[0][row]);
+			m[row][1] = Float4::loadUnaligned(rows[1][row]);
+			m[row][2] = Float4::loadUnaligned(rows[2][row]);
+			m[row][3] = Float4::loadUnaligned(rows[3][row]);
+			// Now m[row][col] holds that element for all four devices
+			transpose(m[row][0], m[row][1], m[row][2], m[row][3]);
+		}
+		m[0][3].store(x + i);
+		m[1][3].store(y + i);
+		m[2][3].store(z + i);
+
+		// toQuat() (glm::quat_cast()) with every branch as a lane mask
+		Float4 fourW = m[0][0] + m[1][1] + m[2][2];
+		Float4 fourX = m[0][0] - m[1][1] - m[2][2];
+		Float4 fourY = m[1][1] - m[0][0] - m[2][2];
+		Float4 fourZ = m[2][2] - m[0][0] - m[1][1];
+		Float4 fourBiggest = fourW;
+		Float4 isX = fourX > fourBiggest;
+		fourBiggest = select(isX, fourX, fourBiggest);
+		Float4 isY = fourY > fourBiggest;
+		fourBiggest = select(isY, fourY, fourBiggest);
+		Float4 useZ = fourZ > fourBiggest;
+		fourBiggest = select(useZ, fourZ, fourBiggest);
+		// A later winner overrides the earlier ones
+		Float4 useY = select(useZ, zero, isY);
+		Float4 useX = select(useZ | isY, zero, isX);
+		Float4 useW = select(useZ | isY | isX, zero, all);
+
+		Float4 big = sqrt(fourBiggest + one) * half;
+		Float4 mult = quarter / big;
+
+		Float4 dx = m[2][1] - m[1][2];
+		Float4 dy = m[0][2] - m[2][0];
+		Float4 dz = m[1][0] - m[0][1];
+		Float4 sxy = m[1][0] + m[0][1];
+		Float4 sxz = m[0][2] + m[2][0];
+		Float4 syz = m[2][1] + m[1][2];
+
+		select(useW, big, select(useX, dx, select(useY, dy, dz)) * mult).store(qw + i);
+		select(useX, big, select(useW, dx, select(useY, sxy, sxz)) * mult).store(qx + i);
+		select(useY, big, select(useW, dy, select(useX, sxy, syz)) * mult).store(qy + i);
+		select(useZ, big, select(useW, dz, select(useX, sxz, syz)) * mult).store(qz + i);
+
+		if (writeMatrices) {
+			for (size_t lane = 0; lane < 4 && i + lane < count; lane++) {
+				// The three rows plus (0, 0, 0, 1), transposed, are the columns
+				Float4 c0 = Float4::loadUnaligned(rows[lane][0]);
+				Float4 c1 = Float4::loadUnaligned(rows[lane][1]);
+				Float4 c2 = Float4::loadUnaligned(rows[lane][2]);
+				Float4 c3 = zero;
+				transpose(c0, c1, c2, c3);
+				float* out = &matrices[i + lane][0][0];
+				c0.storeUnaligned(out);
+				c1.storeUnaligned(out + 4);
+				c2.storeUnaligned(out + 8);
+				c3.storeUnaligned(out + 12);
+				out[15] = 1.0f;
+			}
+		}
+	}
+}
+
+size_t ofxViveTrackerPoseBatch::getCount() const {
+	return count;
+}
+
+bool ofxViveTrackerPoseBatch::isValid(size_t index) const {
+	return index < count && (validMask & (uint64_t(1) << index));
+}
+
+uint64_t ofxViveTrackerPoseBatch::getValidMask() const {
+	return validMask;
+}
+
+glm::vec3 ofxViveTrackerPoseBatch::getPosition(size_t index) const {
+	return glm::vec3(x[index], y[index], z[index]);
+}
+
+glm::quat ofxViveTrackerPoseBatch::getOrientation(size_t index) const {
+	glm::quat q;
+	q.x = qx[index];
+	q.y = qy[index];
+	q.z = qz[index];
+	q.w = qw[index];
+	return q;
+}
+
+const glm::mat4& ofxViveTrackerPoseBatch::getMatrix(size_t index) const {
+	return matrices[index];
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ofMain.h"
+#include <openvr.h>
+
+// Converts a whole TrackedDevicePose_t array at once, four devices per
+// instruction: the 3x4 matrices are transposed into lanes and the
+// quaternion comes straight from the 3x3 block. Per lane the arithmetic is
+// exactly that of ofxViveTrackerMath::toQuat, so results are bit-identical
+// to the scalar path (which is also the fallback without SSE2).
+//
+// Outputs are structure-of-arrays indexed by device index, plus an
+// optional column-major mat4 per device.
+class ofxViveTrackerPoseBatch {
+public:
+	enum {
+		maxDevices = vr::k_unMaxTrackedDeviceCount
+	};
+
+	ofxViveTrackerPoseBatch();
+
+	// Converts poses [0, count), count up to maxDevices.
+	void convert(const vr::TrackedDevicePose_t* poses, size_t count, bool matrices = true);
+
+	size_t getCount() const;
+	// Connected with a valid pose
+	bool isValid(size_t index) const;
+	uint64_t getValidMask() const;
+	glm::vec3 getPosition(size_t index) const;
+	glm::quat getOrientation(size_t index) const;
+	// Only written when convert() was asked for matrices
+	const glm::mat4& getMatrix(size_t index) const;
+
+	// Results of the last convert()
+	alignas(16) float x[maxDevices], y[maxDevices], z[maxDevices];
+	alignas(16) float qx[maxDevices], qy[maxDevices], qz[maxDevices], qw[maxDevices];
+	glm::mat4 matrices[maxDevices];
+
+private:
+	size_t count;
+	uint64_t validMask;
+};
@@ -0,0 +1,240 @@
+#include "ofxViveTrackerPoseBus.h"
+#include "ofxViveTrackerMath.h"
+
+const char ofxViveTrackerPoseBus::magic[8] = { 'O', 'F', 'X', 'V', 'B', 'U', 'S', '\0' };
+
+// Attempts before a reader gives up on an entry the writer keeps replacing
+static const int maxAttempts = 8;
+
+static size_t getEntriesOffset() {
+	return (sizeof(ofxViveTrackerPoseBusHeader) + 63) & ~size_t(63);
+}
+
+static int64_t getSteadyNanoseconds() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ofxViveTrackerPoseBus::ofxViveTrackerPoseBus()
+	: header(nullptr)
+	, entries(nullptr)
+	, historySize(0) {
+}
+
+ofxViveTrackerPoseBus::~ofxViveTrackerPoseBus() {
+	close();
+}
+
+bool ofxViveTrackerPoseBus::open(const std::string& name, size_t history) {
+	close();
+
+	// Power of two so positions map to entries with a mask
+	historySize = 1;
+	while (historySize < std::max<size_t>(history, 2)) {
+		historySize <<= 1;
+	}
+	size_t entriesOffset = getEntriesOffset();
+	size_t size = entriesOffset + vr::k_unMaxTrackedDeviceCount * historySize * sizeof(ofxViveTrackerSeqLock<ofxViveTrackerPoseBusEntry>);
+	if (!memory.create(name, size)) {
+		ofLogError("ofxViveTracker") << "Could not create shared memory " << name;
+		return false;
+	}
+
+	uint8_t* data = (uint8_t*) memory.getData();
+	header = new (data) ofxViveTrackerPoseBusHeader();
+	header->version = version;
+	header->historySize = (uint32_t) historySize;
+	header->entriesOffset = entriesOffset;
+	header->numTrackers = 0;
+	header->heartbeat = getSteadyNanoseconds();
+	for (auto& head : header->heads) {
+		head.store(0, std::memory_order_relaxed);
+	}
+	entries = (ofxViveTrackerSeqLock<ofxViveTrackerPoseBusEntry>*) (data + entriesOffset);
+	for (size_t i = 0; i < vr::k_unMaxTrackedDeviceCount * historySize; i++) {
+		new (&entries[i]) ofxViveTrackerSeqLock<ofxViveTrackerPoseBusEntry>();
+	}
+	for (size_t slot = 0; slot < vr::k_unMaxTrackedDeviceCount; slot++) {
+		heads[slot] = 0;
+		rows[slot] = ofxViveTrackerPoseBusTracker();
+		rows[slot].index = vr::k_unTrackedDeviceIndexInvalid;
+		header->trackers[slot].store(rows[slot]);
+	}
+
+	// Readers check the magic first, so it goes in once everything else is
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(header->magic, magic, sizeof(magic));
+
+	ofLogNotice("ofxViveTracker") << "Sharing poses as " << name;
+	return true;
+}
+
+void ofxViveTrackerPoseBus::close() {
+	memory.close();
+	header = nullptr;
+	entries = nullptr;
+}
+
+bool ofxViveTrackerPoseBus::isOpen() const {
+	return header != nullptr;
+}
+
+void ofxViveTrackerPoseBus::setNumTrackers(size_t count) {
+	header->numTrackers.store((uint32_t) count, std::memory_order_release);
+}
+
+void ofxViveTrackerPoseBus::setTracker(size_t slot, vr::TrackedDeviceIndex_t index, const std::string& serial, bool connected) {
+	ofxViveTrackerPoseBusTracker& row = rows[slot];
+	size_t length = std::min(serial.size(), sizeof(row.serial) - 1);
+	if (row.index == index && row.connected == (uint32_t) connected && strncmp(row.serial, serial.c_str(), sizeof(row.serial)) == 0) {
+		return;
+	}
+	row.index = index;
+	row.connected = connected;
+	memset(row.serial, 0, sizeof(row.serial));
+	memcpy(row.serial, serial.data(), length);
+	header->trackers[slot].store(row);
+}
+
+void ofxViveTrackerPoseBus::add(size_t slot, const ofxViveTrackerSample& sample) {
+	uint64_t position = heads[slot]++;
+	ofxViveTrackerPoseBusEntry entry;
+	entry.position = position;
+	entry.record = ofxViveTrackerRecord::fromSample(sample);
+	entries[slot * historySize + (position & (historySize - 1))].store(entry);
+	header->heads[slot].store(position + 1, std::memory_order_release);
+}
+
+void ofxViveTrackerPoseBus::heartbeat() {
+	header->heartbeat.store(getSteadyNanoseconds(), std::memory_order_relaxed);
+}
+
+ofxViveTrackerPoseBusReader::ofxViveTrackerPoseBusReader()
+	: header(nullptr)
+	, entries(nullptr)
+	, historySize(0) {
+}
+
+bool ofxViveTrackerPoseBusReader::open(const std::string& name) {
+	close();
+	if (!memory.open(name)) {
+		return false;
+	}
+
+	const uint8_t* data = (const uint8_t*) memory.getData();
+	const ofxViveTrackerPoseBusHeader* h = (const ofxViveTrackerPoseBusHeader*) data;
+	bool valid = memory.getSize() >= sizeof(ofxViveTrackerPoseBusHeader)
+		&& memcmp(h->magic, ofxViveTrackerPoseBus::magic, sizeof(h->magic)) == 0;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	valid = valid
+		&& h->version == ofxViveTrackerPoseBus::version
+		&& h->historySize > 0 && (h->historySize & (h->historySize - 1)) == 0
+		&& h->entriesOffset == getEntriesOffset()
+		&& memory.getSize() >= h->entriesOffset + vr::k_unMaxTrackedDeviceCount * h->historySize * sizeof(ofxViveTrackerSeqLock<ofxViveTrackerPoseBusEntry>);
+	if (!valid) {
+		ofLogError("ofxViveTracker") << "Shared memory " << name << " is not a pose bus, or from another version";
+		memory.close();
+		return false;
+	}
+
+	header = h;
+	historySize = h->historySize;
+	entries = (const ofxViveTrackerSeqLock<ofxViveTrackerPoseBusEntry>*) (data + h->entriesOffset);
+	return true;
+}
+
+void ofxViveTrackerPoseBusReader::close() {
+	memory.close();
+	header = nullptr;
+	entries = nullptr;
+}
+
+bool ofxViveTrackerPoseBusReader::isOpen() const {
+	return header != nullptr;
+}
+
+bool ofxViveTrackerPoseBusReader::isAlive(float seconds) const {
+	if (!header) return false;
+	int64_t age = getSteadyNanoseconds() - header->heartbeat.load(std::memory_order_relaxed);
+	return age < (int64_t) (seconds * 1e9);
+}
+
+size_t ofxViveTrackerPoseBusReader::getNumTrackers() const {
+	if (!header) return 0;
+	return std::min<size_t>(header->numTrackers.load(std::memory_order_acquire), vr::k_unMaxTrackedDeviceCount);
+}
+
+bool ofxViveTrackerPoseBusReader::getTracker(size_t slot, ofxViveTrackerPoseBusTracker& tracker) const {
+	if (!header || slot >= vr::k_unMaxTrackedDeviceCount) return false;
+	for (int attempt = 0; attempt < maxAttempts; attempt++) {
+		if (header->trackers[slot].tryLoad(tracker)) {
+			tracker.serial[sizeof(tracker.serial) - 1] = '\0';
+			return true;
+		}
+	}
+	return false;
+}
+
+uint64_t ofxViveTrackerPoseBusReader::getCount(size_t slot) const {
+	if (!header || slot >= vr::k_unMaxTrackedDeviceCount) return 0;
+	return header->heads[slot].load(std::memory_order_acquire);
+}
+
+bool ofxViveTrackerPoseBusReader::getLatest(size_t slot, ofxViveTrackerRecord& record) const {
+	ofxViveTrackerPoseBusEntry entry;
+	for (int attempt = 0; attempt < maxAttempts; attempt++) {
+		uint64_t head = getCount(slot);
+		if (head == 0) return false;
+		uint64_t position = head - 1;
+		if (entries[slot * historySize + (position & (historySize - 1))].tryLoad(entry) && entry.position == position) {
+			record = entry.record;
+			return true;
+		}
+	}
+	return false;
+}
+
+ofxViveTrackerPose ofxViveTrackerPoseBusReader::getPose(size_t slot) const {
+	ofxViveTrackerPose pose;
+	ofxViveTrackerRecord record;
+	if (!getLatest(slot, record)) {
+		return pose;
+	}
+	ofxViveTrackerSample sample = record.toSample();
+	const vr::TrackedDevicePose_t& p = sample.pose;
+	pose.time = sample.time;
+	pose.frame = sample.frame;
+	pose.tracking = p.bDeviceIsConnected && p.bPoseIsValid;
+	if (pose.tracking) {
+		const vr::HmdMatrix34_t& mat = p.mDeviceToAbsoluteTracking;
+		pose.matrix = ofxViveTrackerMath::toMat4(mat);
+		pose.position = ofxViveTrackerMath::toPosition(mat);
+		pose.orientation = ofxViveTrackerMath::toQuat(mat);
+		pose.velocity = glm::vec3(p.vVelocity.v[0], p.vVelocity.v[1], p.vVelocity.v[2]);
+		pose.angularVelocity = glm::vec3(p.vAngularVelocity.v[0], p.vAngularVelocity.v[1], p.vAngularVelocity.v[2]);
+	}
+	return pose;
+}
+
+size_t ofxViveTrackerPoseBusReader::getHistory(size_t slot, ofxViveTrackerRecord* records, size_t count) const {
+	uint64_t head = getCount(slot);
+	uint64_t position = head - std::min<uint64_t>(std::min<uint64_t>(count, head), historySize - 1);
+	return read(slot, position, records, count);
+}
+
+size_t ofxViveTrackerPoseBusReader::read(size_t slot, uint64_t& position, ofxViveTrackerRecord* records, size_t count) const {
+	uint64_t head = getCount(slot);
+	// The oldest entry shares its place with the one being written next
+	if (head > historySize - 1 && position < head - (historySize - 1)) {
+		position = head - (historySize - 1);
+	}
+
+	size_t read = 0;
+	ofxViveTrackerPoseBusEntry entry;
+	for (; position < head && read < count; position++) {
+		const auto& slotEntry = entries[slot * historySize + (position & (historySize - 1))];
+		if (slotEntry.tryLoad(entry) && entry.position == position) {
+			records[read++] = entry.record;
+		}
+	}
+	return read;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "ofxViveTrackerPose.h"
+#include "ofxViveTrackerRecording.h"
+#include "ofxViveTrackerSeqLock.h"
+#include "ofxViveTrackerSharedMemory.h"
+
+// Pose table shared with other processes on the same host through named
+// shared memory. One process writes (ofxViveTracker::startSharing()), any
+// number read with ofxViveTrackerPoseBusReader. Reads are plain loads from
+// the mapping: no locks, no system calls, and a reader can never hold up
+// the writer.
+//
+// Layout, in place in the mapping:
+//
+//   ofxViveTrackerPoseBusHeader          table and per-slot write counts
+//   entries[slot][historySize]           ring of the last poses per slot
+//
+// Every table row and ring entry is an ofxViveTrackerSeqLock, so readers
+// detect and skip anything the writer overwrote while they copied it.
+// Poses are ofxViveTrackerRecords, the same layout as the recording format,
+// with steady_clock times that are valid in every process on the host.
+
+struct ofxViveTrackerPoseBusTracker {
+	uint32_t index;
+	uint32_t connected;
+	char serial[32];
+};
+
+struct ofxViveTrackerPoseBusEntry {
+	uint64_t position;      // Write count of the slot, to detect overwrites
+	ofxViveTrackerRecord record;
+};
+
+struct ofxViveTrackerPoseBusHeader {
+	char magic[8];          // "OFXVBUS\0", written last
+	uint32_t version;
+	uint32_t historySize;   // Entries per slot, a power of two
+	uint64_t entriesOffset; // Bytes from the start of the mapping
+	std::atomic<uint32_t> numTrackers;
+	std::atomic<int64_t> heartbeat; // steady_clock nanoseconds of the last update()
+	ofxViveTrackerSeqLock<ofxViveTrackerPoseBusTracker> trackers[vr::k_unMaxTrackedDeviceCount];
+	// Poses ever written per slot; entry n lives at n % historySize
+	alignas(64) std::atomic<uint64_t> heads[vr::k_unMaxTrackedDeviceCount];
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The pose bus needs lock-free 64-bit atomics to work across processes");
+
+// Writer side, owned by ofxViveTracker.
+class ofxViveTrackerPoseBus {
+public:
+	static const char magic[8];
+	static const uint32_t version = 1;
+
+	ofxViveTrackerPoseBus();
+	~ofxViveTrackerPoseBus();
+
+	bool open(const std::string& name, size_t historySize);
+	void close();
+	bool isOpen() const;
+
+	void setNumTrackers(size_t count);
+	// Only rewrites the row if something changed.
+	void setTracker(size_t slot, vr::TrackedDeviceIndex_t index, const std::string& serial, bool connected);
+	void add(size_t slot, const ofxViveTrackerSample& sample);
+	// Marks the writer alive, once per update().
+	void heartbeat();
+
+private:
+	ofxViveTrackerSharedMemory memory;
+	ofxViveTrackerPoseBusHeader* header;
+	ofxViveTrackerSeqLock<ofxViveTrackerPoseBusEntry>* entries;
+	size_t historySize;
+	uint64_t heads[vr::k_unMaxTrackedDeviceCount];
+	ofxViveTrackerPoseBusTracker rows[vr::k_unMaxTrackedDeviceCount];
+};
+
+// Reader side, for any process on the same host.
+class ofxViveTrackerPoseBusReader {
+public:
+	ofxViveTrackerPoseBusReader();
+
+	bool open(const std::string& name = "ofxViveTracker");
+	void close();
+	bool isOpen() const;
+
+	// Whether the writer called update() within the last few seconds. A
+	// restarted writer creates a new region, so reopen when this goes false.
+	bool isAlive(float seconds = 1.0f) const;
+
+	size_t getNumTrackers() const;
+	bool getTracker(size_t slot, ofxViveTrackerPoseBusTracker& tracker) const;
+
+	// Poses written to a slot so far.
+	uint64_t getCount(size_t slot) const;
+	bool getLatest(size_t slot, ofxViveTrackerRecord& record) const;
+	ofxViveTrackerPose getPose(size_t slot) const;
+	// Up to count of the most recent poses, oldest first.
+	size_t getHistory(size_t slot, ofxViveTrackerRecord* records, size_t count) const;
+	// Every pose from position on, for consumers that must not miss any:
+	// start at getCount() and pass the same position back each time. Poses
+	// the ring overwrote before they were read are skipped.
+	size_t read(size_t slot, uint64_t& position, ofxViveTrackerRecord* records, size_t count) const;
+
+private:
+	ofxViveTrackerSharedMemory memory;
+	const ofxViveTrackerPoseBusHeader* header;
+	const ofxViveTrackerSeqLock<ofxViveTrackerPoseBusEntry>* entries;
+	size_t historySize;
+};
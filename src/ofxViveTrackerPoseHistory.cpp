@@ -0,0 +1,160 @@
+#include "ofxViveTrackerPoseHistory.h"
+#include "ofxViveTrackerKalmanFilter.h"
+#include "ofxViveTrackerMath.h"
+
+ofxViveTrackerPoseHistory::ofxViveTrackerPoseHistory()
+	: size(0) {
+	for (size_t slot = 0; slot < maxSlots; slot++) {
+		heads[slot] = 0;
+		starts[slot] = 0;
+	}
+}
+
+void ofxViveTrackerPoseHistory::setup(size_t n) {
+	size = 0;
+	entries.reset();
+	if (n > 0) {
+		size = 1;
+		while (size < std::max<size_t>(n, 2)) {
+			size <<= 1;
+		}
+		entries.reset(new ofxViveTrackerSeqLock<Entry>[maxSlots * size]);
+	}
+	for (size_t slot = 0; slot < maxSlots; slot++) {
+		heads[slot] = 0;
+		starts[slot] = 0;
+	}
+}
+
+size_t ofxViveTrackerPoseHistory::getSize() const {
+	return size;
+}
+
+void ofxViveTrackerPoseHistory::add(size_t slot, const ofxViveTrackerRawPose& pose) {
+	if (!size || slot >= maxSlots) return;
+	Entry entry;
+	entry.position = heads[slot].load(std::memory_order_relaxed);
+	entry.pose = pose;
+	entries[slot * size + (entry.position & (size - 1))].store(entry);
+	heads[slot].store(entry.position + 1, std::memory_order_release);
+}
+
+void ofxViveTrackerPoseHistory::clear(size_t slot) {
+	if (slot >= maxSlots) return;
+	starts[slot].store(heads[slot].load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+void ofxViveTrackerPoseHistory::clear() {
+	for (size_t slot = 0; slot < maxSlots; slot++) {
+		clear(slot);
+	}
+}
+
+uint64_t ofxViveTrackerPoseHistory::getCount(size_t slot) const {
+	if (slot >= maxSlots) return 0;
+	return heads[slot].load(std::memory_order_acquire) - starts[slot].load(std::memory_order_acquire);
+}
+
+bool ofxViveTrackerPoseHistory::getNewest(size_t slot, ofxViveTrackerRawPose& pose) const {
+	if (!size || slot >= maxSlots) return false;
+	for (int attempt = 0; attempt < 4; attempt++) {
+		uint64_t head = heads[slot].load(std::memory_order_acquire);
+		if (head <= starts[slot].load(std::memory_order_acquire)) return false;
+		if (read(slot, head - 1, pose)) return true;
+	}
+	return false;
+}
+
+bool ofxViveTrackerPoseHistory::read(size_t slot, uint64_t position, ofxViveTrackerRawPose& pose) const {
+	Entry entry = entries[slot * size + (position & (size - 1))].load();
+	if (entry.position != position) return false;
+	pose = entry.pose;
+	return true;
+}
+
+ofxViveTrackerPose ofxViveTrackerPoseHistory::getPoseAt(size_t slot, std::chrono::steady_clock::time_point time, Interpolation interpolation, float maxExtrapolation) const {
+	if (!size || slot >= maxSlots) return ofxViveTrackerPose();
+
+	// A search only fails if the writer laps it, so a retry is enough
+	for (int attempt = 0; attempt < 4; attempt++) {
+		uint64_t head = heads[slot].load(std::memory_order_acquire);
+		uint64_t start = starts[slot].load(std::memory_order_acquire);
+		// The entry at head may be half written and holds head - size
+		uint64_t first = std::max(start, head - std::min<uint64_t>(head, size - 1));
+		if (first >= head) return ofxViveTrackerPose();
+
+		ofxViveTrackerRawPose newest, oldest;
+		if (!read(slot, head - 1, newest)) continue;
+		if (time >= newest.time) {
+			auto limit = newest.time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(maxExtrapolation));
+			return ofxViveTrackerKalmanFilter::extrapolate(newest.toPose(), std::min(time, limit));
+		}
+		if (!read(slot, first, oldest)) continue;
+		if (time <= oldest.time) return oldest.toPose();
+
+		// Keep oldest.time <= time < newest.time while halving the range
+		uint64_t low = first, high = head - 1;
+		bool lapped = false;
+		while (high - low > 1) {
+			uint64_t middle = low + (high - low) / 2;
+			ofxViveTrackerRawPose pose;
+			if (!read(slot, middle, pose)) {
+				lapped = true;
+				break;
+			}
+			if (pose.time <= time) {
+				low = middle;
+				oldest = pose;
+			} else {
+				high = middle;
+				newest = pose;
+			}
+		}
+		if (!lapped) {
+			return interpolate(oldest, newest, time, interpolation);
+		}
+	}
+	return ofxViveTrackerPose();
+}
+
+ofxViveTrackerPose ofxViveTrackerPoseHistory::interpolate(const ofxViveTrackerRawPose& a, const ofxViveTrackerRawPose& b, std::chrono::steady_clock::time_point time, Interpolation interpolation) {
+	float h = std::chrono::duration<float>(b.time - a.time).count();
+	float s = h > 0.0f ? std::chrono::duration<float>(time - a.time).count() / h : 0.0f;
+
+	ofxViveTrackerPose pose;
+	pose.tracking = a.tracking && b.tracking;
+	pose.time = time;
+	pose.frame = s < 0.5f ? a.frame : b.frame;
+
+	glm::vec3 p0 = a.getPosition();
+	glm::vec3 p1 = b.getPosition();
+	glm::quat q0 = ofxViveTrackerMath::toQuat(a.matrix);
+	glm::quat q1 = ofxViveTrackerMath::toQuat(b.matrix);
+	if (glm::dot(q0, q1) < 0.0f) {
+		q1 = -q1;
+	}
+
+	if (interpolation == Interpolation::Hermite && h > 0.0f) {
+		float s2 = s * s, s3 = s2 * s;
+		float h00 = 2.0f * s3 - 3.0f * s2 + 1.0f;
+		float h10 = s3 - 2.0f * s2 + s;
+		float h01 = -2.0f * s3 + 3.0f * s2;
+		float h11 = s3 - s2;
+		pose.position = h00 * p0 + (h10 * h) * a.velocity + h01 * p1 + (h11 * h) * b.velocity;
+		pose.velocity = ((6.0f * s2 - 6.0f * s) / h) * (p0 - p1)
+			+ (3.0f * s2 - 4.0f * s + 1.0f) * a.velocity
+			+ (3.0f * s2 - 2.0f * s) * b.velocity;
+		// The same curve on the rotation away from q0, as a rotation vector
+		glm::vec3 r1 = ofxViveTrackerMath::toRotationVector(q1 * glm::inverse(q0));
+		glm::vec3 r = (h10 * h) * a.angularVelocity + h01 * r1 + (h11 * h) * b.angularVelocity;
+		pose.orientation = glm::normalize(ofxViveTrackerMath::fromRotationVector(r) * q0);
+	} else {
+		pose.position = glm::mix(p0, p1, s);
+		pose.velocity = glm::mix(a.velocity, b.velocity, s);
+		pose.orientation = glm::slerp(q0, q1, s);
+	}
+	pose.angularVelocity = glm::mix(a.angularVelocity, b.angularVelocity, s);
+	pose.acceleration = glm::mix(a.acceleration, b.acceleration, s);
+	pose.matrix = ofxViveTrackerMath::toMat4(pose.orientation, pose.position);
+	return pose;
+}
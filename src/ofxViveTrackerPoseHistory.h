@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ofxViveTrackerPose.h"
+#include "ofxViveTrackerSeqLock.h"
+#include <atomic>
+#include <memory>
+
+// The last poses of every slot in fixed-size rings, for the pose at a
+// given instant rather than the latest one. One thread adds (the update()
+// thread); getPoseAt() is safe from any thread, copies entries through
+// seqlocks and never holds up the writer. All memory is allocated by
+// setup(), nothing after.
+class ofxViveTrackerPoseHistory {
+public:
+	enum {
+		maxSlots = vr::k_unMaxTrackedDeviceCount
+	};
+
+	enum class Interpolation {
+		Linear, // Linear position and velocities, slerp orientation
+		Hermite // Cubic Hermite through both poses and their velocities
+	};
+
+	ofxViveTrackerPoseHistory();
+
+	// Poses kept per slot, rounded up to a power of two; 0 disables the
+	// history. Not thread safe, call before the first add().
+	void setup(size_t size);
+	size_t getSize() const;
+
+	void add(size_t slot, const ofxViveTrackerRawPose& pose);
+	// Forgets the poses of a slot, for when they no longer describe the
+	// same device or frame.
+	void clear(size_t slot);
+	void clear();
+	// Poses added to a slot since the last clear.
+	uint64_t getCount(size_t slot) const;
+	// Most recent pose of a slot, false if there is none.
+	bool getNewest(size_t slot, ofxViveTrackerRawPose& pose) const;
+
+	// Pose of slot at time, interpolated between the two poses around it.
+	// Later than the newest pose it is extrapolated, by at most
+	// maxExtrapolation seconds; earlier than the oldest it is the oldest.
+	// Not tracking if the slot has no poses.
+	ofxViveTrackerPose getPoseAt(size_t slot, std::chrono::steady_clock::time_point time, Interpolation interpolation = Interpolation::Linear, float maxExtrapolation = 0.05f) const;
+
+	static ofxViveTrackerPose interpolate(const ofxViveTrackerRawPose& a, const ofxViveTrackerRawPose& b, std::chrono::steady_clock::time_point time, Interpolation interpolation);
+
+private:
+	struct Entry {
+		uint64_t position; // Write count of the slot, to detect overwrites
+		ofxViveTrackerRawPose pose;
+	};
+
+	bool read(size_t slot, uint64_t position, ofxViveTrackerRawPose& pose) const;
+
+	std::unique_ptr<ofxViveTrackerSeqLock<Entry>[]> entries;
+	size_t size;
+	// Poses ever added per slot; entry n lives at n % size
+	std::atomic<uint64_t> heads[maxSlots];
+	// First position since the last clear()
+	std::atomic<uint64_t> starts[maxSlots];
+};
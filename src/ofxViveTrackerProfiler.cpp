@@ -0,0 +1,107 @@
+#include "ofxViveTrackerProfiler.h"
+#include <algorithm>
+#include <cstdio>
+
+ofxViveTrackerProfiler::ofxViveTrackerProfiler() {
+	reset();
+}
+
+int ofxViveTrackerProfiler::getBucket(uint64_t ns) {
+	// Exact below 16ns, then 8 linear buckets per power of two
+	if (ns < 16) return int(ns);
+	int exponent = 63;
+	while (!(ns & (uint64_t(1) << exponent))) exponent--;
+	int sub = int(ns >> (exponent - 3)) & 7;
+	int bucket = 16 + (exponent - 4) * 8 + sub;
+	return bucket < numBuckets ? bucket : numBuckets - 1;
+}
+
+double ofxViveTrackerProfiler::getBucketMiddle(int bucket) {
+	if (bucket < 16) return bucket;
+	int exponent = (bucket - 16) / 8 + 4;
+	int sub = (bucket - 16) % 8;
+	double width = double(uint64_t(1) << (exponent - 3));
+	return (8 + sub) * width + 0.5 * width;
+}
+
+void ofxViveTrackerProfiler::add(Stage stage, std::chrono::steady_clock::duration elapsed) {
+	int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+	uint64_t value = ns > 0 ? uint64_t(ns) : 0;
+	Histogram& h = histograms[int(stage)];
+	h.count.fetch_add(1, std::memory_order_relaxed);
+	h.total.fetch_add(value, std::memory_order_relaxed);
+	h.buckets[getBucket(value)].fetch_add(1, std::memory_order_relaxed);
+	uint64_t max = h.max.load(std::memory_order_relaxed);
+	while (value > max && !h.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+	}
+}
+
+ofxViveTrackerTimingStats ofxViveTrackerProfiler::getStats(Stage stage) const {
+	const Histogram& h = histograms[int(stage)];
+	ofxViveTrackerTimingStats stats;
+
+	// Buckets are read one by one while writers go on, so use their own sum
+	uint32_t counts[numBuckets];
+	uint64_t count = 0;
+	for (int i = 0; i < numBuckets; i++) {
+		counts[i] = h.buckets[i].load(std::memory_order_relaxed);
+		count += counts[i];
+	}
+	if (count == 0) return stats;
+
+	stats.count = h.count.load(std::memory_order_relaxed);
+	stats.max = h.max.load(std::memory_order_relaxed) / 1000.0;
+	stats.mean = stats.count ? h.total.load(std::memory_order_relaxed) / 1000.0 / stats.count : 0.0;
+
+	auto percentile = [&](double fraction) {
+		uint64_t rank = uint64_t(fraction * (count - 1));
+		uint64_t seen = 0;
+		for (int i = 0; i < numBuckets; i++) {
+			seen += counts[i];
+			if (seen > rank) return std::min(getBucketMiddle(i) / 1000.0, stats.max);
+		}
+		return stats.max;
+	};
+	stats.p50 = percentile(0.5);
+	stats.p99 = percentile(0.99);
+	return stats;
+}
+
+void ofxViveTrackerProfiler::reset() {
+	for (auto& h : histograms) {
+		h.count = 0;
+		h.total = 0;
+		h.max = 0;
+		for (auto& bucket : h.buckets) {
+			bucket = 0;
+		}
+	}
+}
+
+const char* ofxViveTrackerProfiler::getName(Stage stage) {
+	switch (stage) {
+	case Stage::Update: return "update";
+	case Stage::Events: return "events";
+	case Stage::Discovery: return "discovery";
+	case Stage::Fetch: return "fetch";
+	case Stage::Drain: return "drain";
+	case Stage::Convert: return "convert";
+	case Stage::Filter: return "filter";
+	case Stage::Output: return "output";
+	case Stage::Connect: return "connect";
+	default: return "";
+	}
+}
+
+std::string ofxViveTrackerProfiler::getReport() const {
+	std::string report;
+	char line[160];
+	for (int i = 0; i < numStages; i++) {
+		ofxViveTrackerTimingStats stats = getStats(Stage(i));
+		if (!stats.count) continue;
+		snprintf(line, sizeof(line), "%-10s n=%-8llu mean=%9.2fus p50=%9.2fus p99=%9.2fus max=%9.2fus\n",
+			getName(Stage(i)), (unsigned long long)stats.count, stats.mean, stats.p50, stats.p99, stats.max);
+		report += line;
+	}
+	return report;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Per-stage timing of ofxViveTracker::update() and its worker threads.
+// Each stage keeps a streaming log-scale histogram (8 buckets per power of
+// two, so percentiles are within 12.5%) plus exact count, mean and max.
+//
+// Define OFXVIVETRACKER_NO_PROFILING to compile every timer out; the stats
+// then stay empty.
+struct ofxViveTrackerTimingStats {
+	uint64_t count;
+	// Microseconds
+	double mean;
+	double p50;
+	double p99;
+	double max;
+
+	ofxViveTrackerTimingStats()
+		: count(0)
+		, mean(0.0)
+		, p50(0.0)
+		, p99(0.0)
+		, max(0.0) {
+	}
+};
+
+class ofxViveTrackerProfiler {
+public:
+	enum class Stage {
+		Update,    // All of update()
+		Events,    // Polling and handling VR events
+		Discovery, // Rescanning trackers after the device registry changed
+		Fetch,     // Vsync timing and GetDeviceToAbsoluteTrackingPose (pose thread when threaded)
+		Drain,     // Popping samples off the ring buffer (threaded mode)
+		Convert,   // Matrix to position/quaternion, Kalman updates and publishing
+		Filter,    // One Euro filter and fusing older samples into the Kalman filter
+		Output,    // Recording and shared memory
+		Connect,   // One connection attempt (connect thread)
+		Count
+	};
+
+	enum {
+		numStages = int(Stage::Count),
+		numBuckets = 16 + 36 * 8
+	};
+
+	ofxViveTrackerProfiler();
+
+	// Safe from any thread. Each stage should only be timed from one thread
+	// at a time.
+	void add(Stage stage, std::chrono::steady_clock::duration elapsed);
+	ofxViveTrackerTimingStats getStats(Stage stage) const;
+	void reset();
+
+	static const char* getName(Stage stage);
+	// One line per stage that ran: count, mean, p50, p99 and max.
+	std::string getReport() const;
+
+	// Times the enclosing block.
+	class Scope {
+	public:
+		Scope(ofxViveTrackerProfiler& profiler, Stage stage)
+			: profiler(profiler)
+			, stage(stage)
+			, start(std::chrono::steady_clock::now()) {
+		}
+		~Scope() {
+			profiler.add(stage, std::chrono::steady_clock::now() - start);
+		}
+
+	private:
+		ofxViveTrackerProfiler& profiler;
+		Stage stage;
+		std::chrono::steady_clock::time_point start;
+	};
+
+private:
+	struct Histogram {
+		std::atomic<uint64_t> count;
+		std::atomic<uint64_t> total;
+		std::atomic<uint64_t> max;
+		std::atomic<uint32_t> buckets[numBuckets];
+	};
+
+	Histogram histograms[numStages];
+
+	static int getBucket(uint64_t nanoseconds);
+	static double getBucketMiddle(int bucket);
+};
+
+#ifndef OFXVIVETRACKER_NO_PROFILING
+#define OFXVIVETRACKER_PROFILE_CONCAT2(a, b) a##b
+#define OFXVIVETRACKER_PROFILE_CONCAT(a, b) OFXVIVETRACKER_PROFILE_CONCAT2(a, b)
+#define OFXVIVETRACKER_PROFILE(profiler, stage) ofxViveTrackerProfiler::Scope OFXVIVETRACKER_PROFILE_CONCAT(profileScope, __LINE__)(profiler, ofxViveTrackerProfiler::Stage::stage)
+#else
+#define OFXVIVETRACKER_PROFILE(profiler, stage)
+#endif
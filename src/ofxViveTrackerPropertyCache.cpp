@@ -0,0 +1,172 @@
+#include "ofxViveTrackerPropertyCache.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	template<size_t N>
+	void copyString(char (&dest)[N], const std::string& value) {
+		size_t length = std::min(value.size(), N - 1);
+		memcpy(dest, value.data(), length);
+		dest[length] = '\0';
+	}
+}
+
+ofxViveTrackerDeviceProperties::ofxViveTrackerDeviceProperties()
+	: valid(false)
+	, deviceClass(vr::TrackedDeviceClass_Invalid)
+	, hasBattery(false)
+	, batteryLevel(0.0f) {
+	serial[0] = '\0';
+	model[0] = '\0';
+	controllerType[0] = '\0';
+	manufacturer[0] = '\0';
+	firmware[0] = '\0';
+}
+
+ofxViveTrackerPropertyCache::ofxViveTrackerPropertyCache()
+	: running(false)
+	, refreshInterval(0)
+	, sliceInterval(0)
+	, dirtyMask(0)
+	, numQueries(0) {
+	for (auto& deviceClass : deviceClasses) {
+		deviceClass = vr::TrackedDeviceClass_Invalid;
+	}
+}
+
+ofxViveTrackerPropertyCache::~ofxViveTrackerPropertyCache() {
+	stop();
+}
+
+void ofxViveTrackerPropertyCache::start(std::shared_ptr<ofxViveTrackerSource> src, float refresh, float slice) {
+	stop();
+	source = src;
+	refreshInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(std::max(refresh, 0.0f)));
+	sliceInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(std::max(slice, 0.0f)));
+	// Everything already known is read first
+	std::fill(std::begin(lastRead), std::end(lastRead), std::chrono::steady_clock::time_point());
+	invalidateAll();
+	running = true;
+	thread = std::thread(&ofxViveTrackerPropertyCache::threadFunction, this);
+}
+
+void ofxViveTrackerPropertyCache::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	condition.notify_all();
+	if (thread.joinable()) {
+		thread.join();
+	}
+	source.reset();
+	// The thread is gone, so this is the only writer now
+	for (auto& entry : entries) {
+		entry.store(ofxViveTrackerDeviceProperties());
+	}
+}
+
+bool ofxViveTrackerPropertyCache::isRunning() const {
+	return thread.joinable();
+}
+
+void ofxViveTrackerPropertyCache::setDeviceClass(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceClass deviceClass) {
+	if (index >= maxDevices) return;
+	deviceClasses[index] = deviceClass;
+	invalidate(index);
+}
+
+void ofxViveTrackerPropertyCache::invalidate(vr::TrackedDeviceIndex_t index) {
+	if (index >= maxDevices) return;
+	dirtyMask.fetch_or(uint64_t(1) << index);
+	wake();
+}
+
+void ofxViveTrackerPropertyCache::invalidateAll() {
+	dirtyMask = ~uint64_t(0);
+	wake();
+}
+
+void ofxViveTrackerPropertyCache::wake() {
+	// Under the mutex, so the thread can't miss it between checking and waiting
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+	}
+	condition.notify_all();
+}
+
+ofxViveTrackerDeviceProperties ofxViveTrackerPropertyCache::get(vr::TrackedDeviceIndex_t index) const {
+	if (index >= maxDevices) return ofxViveTrackerDeviceProperties();
+	return entries[index].load();
+}
+
+uint64_t ofxViveTrackerPropertyCache::getNumQueries() const {
+	return numQueries;
+}
+
+void ofxViveTrackerPropertyCache::threadFunction() {
+	auto nextSlice = std::chrono::steady_clock::now();
+	std::unique_lock<std::mutex> lock(mutex);
+	while (running) {
+		auto now = std::chrono::steady_clock::now();
+		if (now < nextSlice) {
+			condition.wait_until(lock, nextSlice);
+			continue;
+		}
+
+		auto due = now + refreshInterval;
+		int index = nextDevice(now, due);
+		if (index < 0) {
+			// Until a device is due or an event invalidates one
+			condition.wait_until(lock, due);
+			continue;
+		}
+
+		lock.unlock();
+		read(vr::TrackedDeviceIndex_t(index));
+		lock.lock();
+		nextSlice = std::chrono::steady_clock::now() + sliceInterval;
+	}
+}
+
+int ofxViveTrackerPropertyCache::nextDevice(std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point& due) {
+	uint64_t dirty = dirtyMask.load();
+	for (int i = 0; i < maxDevices; i++) {
+		if (!((dirty >> i) & 1)) continue;
+		dirtyMask.fetch_and(~(uint64_t(1) << i));
+		// Devices that are gone only need their entry cleared, once
+		if (deviceClasses[i] != vr::TrackedDeviceClass_Invalid || entries[i].load().valid) {
+			return i;
+		}
+	}
+
+	int oldest = -1;
+	for (int i = 0; i < maxDevices; i++) {
+		if (deviceClasses[i] == vr::TrackedDeviceClass_Invalid) continue;
+		if (oldest < 0 || lastRead[i] < lastRead[oldest]) oldest = i;
+	}
+	if (oldest < 0) return -1;
+	if (lastRead[oldest] + refreshInterval <= now) return oldest;
+	due = lastRead[oldest] + refreshInterval;
+	return -1;
+}
+
+void ofxViveTrackerPropertyCache::read(vr::TrackedDeviceIndex_t index) {
+	ofxViveTrackerDeviceProperties properties;
+	properties.deviceClass = deviceClasses[index];
+	properties.time = std::chrono::steady_clock::now();
+	lastRead[index] = properties.time;
+
+	if (properties.deviceClass != vr::TrackedDeviceClass_Invalid) {
+		properties.valid = true;
+		properties.hasBattery = source->getFloatProperty(index, vr::Prop_DeviceBatteryPercentage_Float, properties.batteryLevel);
+		if (!properties.hasBattery) properties.batteryLevel = 0.0f;
+		copyString(properties.serial, source->getStringProperty(index, vr::Prop_SerialNumber_String));
+		copyString(properties.model, source->getStringProperty(index, vr::Prop_ModelNumber_String));
+		copyString(properties.controllerType, source->getStringProperty(index, vr::Prop_ControllerType_String));
+		copyString(properties.manufacturer, source->getStringProperty(index, vr::Prop_ManufacturerName_String));
+		copyString(properties.firmware, source->getStringProperty(index, vr::Prop_TrackingFirmwareVersion_String));
+		numQueries += 6;
+	}
+	entries[index].store(properties);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ofxViveTrackerSeqLock.h"
+#include "ofxViveTrackerSource.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Slowly changing properties of one device as last read by
+// ofxViveTrackerPropertyCache. Trivially copyable; strings are truncated
+// to fit.
+struct ofxViveTrackerDeviceProperties {
+	enum {
+		maxStringSize = 64
+	};
+
+	// False until the device has been read, and again once it is gone
+	bool valid;
+	// When the properties were read
+	std::chrono::steady_clock::time_point time;
+	vr::ETrackedDeviceClass deviceClass;
+
+	// Prop_DeviceBatteryPercentage_Float, 0 to 1, if the device has one
+	bool hasBattery;
+	float batteryLevel;
+
+	char serial[maxStringSize];
+	char model[maxStringSize];          // Prop_ModelNumber_String
+	char controllerType[maxStringSize]; // Prop_ControllerType_String
+	char manufacturer[maxStringSize];   // Prop_ManufacturerName_String
+	char firmware[maxStringSize];       // Prop_TrackingFirmwareVersion_String
+
+	ofxViveTrackerDeviceProperties();
+};
+
+// Device properties for dashboards, read on a background thread so that
+// nothing that renders ever waits for vrserver. The thread reads one device
+// per slice: devices invalidated by events first, then whichever was read
+// longest ago once it is older than the refresh interval. get() copies
+// through a seqlock and is safe from any thread.
+class ofxViveTrackerPropertyCache {
+public:
+	enum {
+		maxDevices = vr::k_unMaxTrackedDeviceCount
+	};
+
+	ofxViveTrackerPropertyCache();
+	~ofxViveTrackerPropertyCache();
+
+	// Starts reading from source, which must stay connected until stop().
+	// At most one device every sliceInterval seconds, and each device again
+	// refreshInterval seconds after it was last read.
+	void start(std::shared_ptr<ofxViveTrackerSource> source, float refreshInterval = 10.0f, float sliceInterval = 0.01f);
+	// Joins the thread and forgets every device.
+	void stop();
+	bool isRunning() const;
+
+	// Device events, from one thread at a time. Setting the class of a
+	// device (Invalid once it is gone) or invalidating it has it read again
+	// in the next slice.
+	void setDeviceClass(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceClass deviceClass);
+	void invalidate(vr::TrackedDeviceIndex_t index);
+	void invalidateAll();
+
+	// Not valid for devices that were never read or are gone.
+	ofxViveTrackerDeviceProperties get(vr::TrackedDeviceIndex_t index) const;
+	// Property queries made so far, each an IPC round trip with OpenVR.
+	uint64_t getNumQueries() const;
+
+private:
+	void threadFunction();
+	// Next device to read, or -1 and the time one becomes due
+	int nextDevice(std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point& due);
+	void read(vr::TrackedDeviceIndex_t index);
+	void wake();
+
+	std::shared_ptr<ofxViveTrackerSource> source;
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool running;
+	std::chrono::steady_clock::duration refreshInterval;
+	std::chrono::steady_clock::duration sliceInterval;
+
+	std::atomic<vr::ETrackedDeviceClass> deviceClasses[maxDevices];
+	std::atomic<uint64_t> dirtyMask;
+	std::atomic<uint64_t> numQueries;
+	// Only touched by the thread
+	std::chrono::steady_clock::time_point lastRead[maxDevices];
+
+	ofxViveTrackerSeqLock<ofxViveTrackerDeviceProperties> entries[maxDevices];
+};
@@ -0,0 +1,33 @@
+#include "ofxViveTrackerPublishedPose.h"
+
+ofxViveTrackerPublishedPose::ofxViveTrackerPublishedPose()
+	: stores(0)
+	, cacheBusy(false)
+	, cachedSample(0) {
+	// Sample 0 is the default pose, already converted
+	cached = ofxViveTrackerRawPose().toPose();
+}
+
+void ofxViveTrackerPublishedPose::store(const ofxViveTrackerRawPose& pose) {
+	ofxViveTrackerRawPose stamped = pose;
+	stamped.sample = ++stores;
+	raw.store(stamped);
+}
+
+ofxViveTrackerRawPose ofxViveTrackerPublishedPose::loadRaw() const {
+	return raw.load();
+}
+
+ofxViveTrackerPose ofxViveTrackerPublishedPose::load() const {
+	ofxViveTrackerRawPose pose = raw.load();
+	if (cacheBusy.exchange(true, std::memory_order_acquire)) {
+		return pose.toPose();
+	}
+	if (cachedSample != pose.sample) {
+		cached = pose.toPose();
+		cachedSample = pose.sample;
+	}
+	ofxViveTrackerPose result = cached;
+	cacheBusy.store(false, std::memory_order_release);
+	return result;
+}
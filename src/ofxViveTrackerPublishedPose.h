@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ofxViveTrackerPose.h"
+#include "ofxViveTrackerSeqLock.h"
+#include <atomic>
+
+// One slot of a pose table shared between threads. The writer publishes
+// raw poses; readers take position and derivatives straight from them and
+// derive orientation and mat4 on the first full load() of each sample,
+// sharing the result through a cache. Neither side ever blocks: a reader
+// that finds the cache busy converts on its own.
+class ofxViveTrackerPublishedPose {
+public:
+	ofxViveTrackerPublishedPose();
+
+	// Only one thread may call store(). Stamps raw.sample with a count of
+	// its own, so the cache can't mix up poses.
+	void store(const ofxViveTrackerRawPose& raw);
+
+	ofxViveTrackerRawPose loadRaw() const;
+	ofxViveTrackerPose load() const;
+
+private:
+	ofxViveTrackerSeqLock<ofxViveTrackerRawPose> raw;
+	uint64_t stores;
+
+	mutable std::atomic<bool> cacheBusy;
+	mutable uint64_t cachedSample;
+	mutable ofxViveTrackerPose cached;
+};
@@ -0,0 +1,300 @@
+#include "ofxViveTrackerReceiver.h"
+
+namespace {
+	template<class T>
+	inline T read(const uint8_t*& in) {
+		T value;
+		memcpy(&value, in, sizeof(value));
+		in += sizeof(value);
+		return value;
+	}
+}
+
+ofxViveTrackerReceiver::ofxViveTrackerReceiver()
+	: buffers(batchSize * ofxViveTrackerBroadcaster::maxPacketSize)
+	, connected(false)
+	, tracking(false)
+	, timeout(1.0f)
+	, haveSequence(false)
+	, sequence(0)
+	, synced(false)
+	, receivedPackets(0)
+	, lostPackets(0)
+	, skippedPackets(0) {
+	trackers.reserve(vr::k_unMaxTrackedDeviceCount);
+	for (int& slot : slotForIndex) {
+		slot = -1;
+	}
+}
+
+bool ofxViveTrackerReceiver::setup(int port, const std::string& host) {
+	if (!socket.open() || !socket.bind(port, host)) {
+		ofLogError("ofxViveTracker") << "Could not listen on UDP port " << port;
+		socket.close();
+		return false;
+	}
+	ofLogNotice("ofxViveTracker") << "Receiving poses on port " << port;
+	return true;
+}
+
+void ofxViveTrackerReceiver::update() {
+	if (!socket.isOpen()) {
+		return;
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	size_t count;
+	do {
+		count = socket.receive(buffers.data(), ofxViveTrackerBroadcaster::maxPacketSize, sizes, batchSize);
+		for (size_t i = 0; i < count; i++) {
+			if (handlePacket(buffers.data() + i * ofxViveTrackerBroadcaster::maxPacketSize, sizes[i], now)) {
+				receivedPackets++;
+				lastReceived = now;
+			}
+		}
+	} while (count == batchSize);
+
+	if (connected && now - lastReceived > std::chrono::duration<float>(timeout)) {
+		ofLogWarning("ofxViveTracker") << "No poses received for " << timeout << " seconds";
+		disconnectAll();
+	}
+	updateConnectionState();
+}
+
+void ofxViveTrackerReceiver::close() {
+	socket.close();
+	disconnectAll();
+	updateConnectionState();
+	haveSequence = false;
+	synced = false;
+}
+
+void ofxViveTrackerReceiver::setCodecSettings(const ofxViveTrackerCodec::Settings& settings) {
+	codec.setup(settings);
+	synced = false;
+}
+
+void ofxViveTrackerReceiver::setTimeout(float seconds) {
+	timeout = seconds;
+}
+
+bool ofxViveTrackerReceiver::handlePacket(const uint8_t* data, size_t size, std::chrono::steady_clock::time_point now) {
+	const uint8_t* p = data;
+	const uint8_t* end = data + size;
+	if (size < ofxViveTrackerBroadcaster::headerSize || memcmp(p, ofxViveTrackerBroadcaster::magic, sizeof(ofxViveTrackerBroadcaster::magic)) != 0) {
+		return false;
+	}
+	p += sizeof(ofxViveTrackerBroadcaster::magic);
+	if (read<uint8_t>(p) != ofxViveTrackerBroadcaster::version) {
+		return false;
+	}
+	uint8_t flags = read<uint8_t>(p);
+	uint8_t numSlots = read<uint8_t>(p);
+	read<uint8_t>(p);
+	uint32_t packetSequence = read<uint32_t>(p);
+	int64_t sendTime = read<int64_t>(p);
+	read<int64_t>(p);
+	if (numSlots > vr::k_unMaxTrackedDeviceCount) {
+		return false;
+	}
+
+	// Drop duplicates and late arrivals. After a timeout anything goes, so
+	// a restarted sender is picked up again
+	int32_t gap = (int32_t) (packetSequence - sequence);
+	bool fresh = !haveSequence || now - lastReceived > std::chrono::duration<float>(timeout);
+	if (!fresh && gap <= 0) {
+		return false;
+	}
+	if (!fresh && gap > 1) {
+		lostPackets += gap - 1;
+	}
+	haveSequence = true;
+	sequence = packetSequence;
+
+	// Deltas only decode on top of the datagram before them
+	bool keyframe = (flags & 2) != 0;
+	synced = synced && !fresh && gap == 1;
+	if (!keyframe && !synced) {
+		skippedPackets++;
+		return false;
+	}
+	// Until this one decodes
+	synced = false;
+
+	// Parse everything before touching the table, so a bad datagram
+	// changes nothing
+	const uint8_t* serials[vr::k_unMaxTrackedDeviceCount];
+	uint8_t serialLengths[vr::k_unMaxTrackedDeviceCount];
+	bool haveSerials = (flags & 1) != 0;
+	if (haveSerials) {
+		for (size_t slot = 0; slot < numSlots; slot++) {
+			if (p >= end || *p > end - p - 1) return false;
+			serialLengths[slot] = *p++;
+			serials[slot] = p;
+			p += serialLengths[slot];
+		}
+	}
+
+	ofxViveTrackerSample samples[vr::k_unMaxTrackedDeviceCount];
+	for (size_t slot = 0; slot < numSlots; slot++) {
+		if (p < end && *p == ofxViveTrackerBroadcaster::noDevice) {
+			p++;
+			samples[slot] = ofxViveTrackerSample();
+			samples[slot].time = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::microseconds(sendTime)));
+			samples[slot].index = vr::k_unTrackedDeviceIndexInvalid;
+			samples[slot].pose.eTrackingResult = vr::TrackingResult_Uninitialized;
+			continue;
+		}
+		size_t used = codec.decode(p, end - p, samples[slot]);
+		if (!used) return false;
+		p += used;
+	}
+	synced = true;
+
+	// Sender steady_clock to ours
+	auto offset = now.time_since_epoch() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::microseconds(sendTime));
+
+	bool tableChanged = numSlots != trackers.size();
+	for (size_t slot = numSlots; slot < trackers.size(); slot++) {
+		publishedPoses[slot].store(ofxViveTrackerRawPose());
+	}
+	trackers.resize(numSlots);
+	for (size_t slot = 0; slot < numSlots; slot++) {
+		ofxViveTrackerDevice& device = trackers[slot];
+		const ofxViveTrackerSample& sample = samples[slot];
+		const vr::TrackedDevicePose_t& p = sample.pose;
+
+		if (haveSerials && device.serial.compare(0, std::string::npos, (const char*) serials[slot], serialLengths[slot]) != 0) {
+			device.serial.assign((const char*) serials[slot], serialLengths[slot]);
+			tableChanged = true;
+		}
+		if (device.index != sample.index) {
+			device.index = sample.index;
+			tableChanged = true;
+		}
+		device.connected = p.bDeviceIsConnected;
+
+		ofxViveTrackerRawPose& raw = device.raw;
+		raw.time = sample.time + offset;
+		raw.frame = sample.frame;
+		raw.sample++;
+		raw.tracking = p.bDeviceIsConnected && p.bPoseIsValid;
+		raw.trackingResult = p.eTrackingResult;
+		if (raw.tracking) {
+			raw.matrix = p.mDeviceToAbsoluteTracking;
+			raw.velocity = glm::vec3(p.vVelocity.v[0], p.vVelocity.v[1], p.vVelocity.v[2]);
+			raw.angularVelocity = glm::vec3(p.vAngularVelocity.v[0], p.vAngularVelocity.v[1], p.vAngularVelocity.v[2]);
+		}
+		publishedPoses[slot].store(raw);
+	}
+
+	if (tableChanged) {
+		rebuildMaps();
+	}
+	return true;
+}
+
+void ofxViveTrackerReceiver::rebuildMaps() {
+	for (int& slot : slotForIndex) {
+		slot = -1;
+	}
+	slotForSerial.clear();
+	for (size_t slot = 0; slot < trackers.size(); slot++) {
+		const ofxViveTrackerDevice& device = trackers[slot];
+		if (device.index < vr::k_unMaxTrackedDeviceCount) {
+			slotForIndex[device.index] = (int) slot;
+		}
+		if (!device.serial.empty()) {
+			slotForSerial[device.serial] = slot;
+		}
+	}
+}
+
+void ofxViveTrackerReceiver::disconnectAll() {
+	for (size_t slot = 0; slot < trackers.size(); slot++) {
+		trackers[slot].connected = false;
+		trackers[slot].raw.tracking = false;
+		trackers[slot].raw.sample++;
+		publishedPoses[slot].store(trackers[slot].raw);
+	}
+}
+
+void ofxViveTrackerReceiver::updateConnectionState() {
+	connected = false;
+	for (const auto& tracker : trackers) {
+		connected = connected || tracker.connected;
+	}
+	tracking = !trackers.empty() && trackers[0].raw.tracking;
+}
+
+bool ofxViveTrackerReceiver::isConnected() const {
+	return connected;
+}
+
+bool ofxViveTrackerReceiver::isTracking() const {
+	return tracking;
+}
+
+glm::vec3 ofxViveTrackerReceiver::getPosition() const {
+	return publishedPoses[0].loadRaw().getPosition();
+}
+
+glm::quat ofxViveTrackerReceiver::getOrientation() const {
+	return getPose().orientation;
+}
+
+glm::mat4 ofxViveTrackerReceiver::getMatrix() const {
+	return getPose().matrix;
+}
+
+glm::vec3 ofxViveTrackerReceiver::getVelocity() const {
+	return publishedPoses[0].loadRaw().velocity;
+}
+
+glm::vec3 ofxViveTrackerReceiver::getAngularVelocity() const {
+	return publishedPoses[0].loadRaw().angularVelocity;
+}
+
+ofxViveTrackerPose ofxViveTrackerReceiver::getPose() const {
+	return publishedPoses[0].load();
+}
+
+ofxViveTrackerPose ofxViveTrackerReceiver::getPose(size_t slot) const {
+	if (slot >= vr::k_unMaxTrackedDeviceCount) return ofxViveTrackerPose();
+	return publishedPoses[slot].load();
+}
+
+size_t ofxViveTrackerReceiver::getNumTrackers() const {
+	return trackers.size();
+}
+
+const ofxViveTrackerDevice& ofxViveTrackerReceiver::getTracker(size_t slot) const {
+	return trackers[slot];
+}
+
+const ofxViveTrackerDevice* ofxViveTrackerReceiver::getTrackerByIndex(vr::TrackedDeviceIndex_t index) const {
+	if (index >= vr::k_unMaxTrackedDeviceCount || slotForIndex[index] < 0) return nullptr;
+	return &trackers[slotForIndex[index]];
+}
+
+const ofxViveTrackerDevice* ofxViveTrackerReceiver::getTrackerBySerial(const std::string& serial) const {
+	auto it = slotForSerial.find(serial);
+	if (it == slotForSerial.end()) return nullptr;
+	return &trackers[it->second];
+}
+
+uint32_t ofxViveTrackerReceiver::getSequence() const {
+	return sequence;
+}
+
+uint64_t ofxViveTrackerReceiver::getReceivedPackets() const {
+	return receivedPackets;
+}
+
+uint64_t ofxViveTrackerReceiver::getLostPackets() const {
+	return lostPackets;
+}
+
+uint64_t ofxViveTrackerReceiver::getSkippedPackets() const {
+	return skippedPackets;
+}
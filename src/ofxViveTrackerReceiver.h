@@ -0,0 +1,89 @@
+#pragma once
+
+#include "ofxViveTrackerBroadcaster.h"
+
+// Receives the tracker table sent by ofxViveTrackerBroadcaster and exposes
+// it through the same getters as ofxViveTracker. Slots match the sender's.
+//
+// Pose times are moved into this machine's steady_clock by assuming the
+// datagram arrived the moment it was sent, which is off by the network
+// latency (well under a millisecond on a wired LAN).
+//
+// Datagrams are delta coded, so after a lost or bad one nothing is applied
+// until the next keyframe.
+class ofxViveTrackerReceiver {
+public:
+	ofxViveTrackerReceiver();
+
+	// Listen on port, on every interface if host is empty.
+	bool setup(int port, const std::string& host = "");
+	// Applies every datagram that arrived since the previous call, in
+	// sequence order. Never blocks.
+	void update();
+	void close();
+
+	// Must match the sender.
+	void setCodecSettings(const ofxViveTrackerCodec::Settings& settings);
+	// Trackers count as disconnected when nothing arrives for this long.
+	void setTimeout(float seconds);
+
+	bool isConnected() const;
+	bool isTracking() const;
+
+	glm::vec3 getPosition() const;
+	glm::quat getOrientation() const;
+	glm::mat4 getMatrix() const;
+
+	glm::vec3 getVelocity() const;
+	glm::vec3 getAngularVelocity() const;
+
+	// Consistent snapshot, safe to call from any thread.
+	ofxViveTrackerPose getPose() const;
+	ofxViveTrackerPose getPose(size_t slot) const;
+
+	// The table only changes inside update().
+	size_t getNumTrackers() const;
+	const ofxViveTrackerDevice& getTracker(size_t slot) const;
+	const ofxViveTrackerDevice* getTrackerByIndex(vr::TrackedDeviceIndex_t index) const;
+	const ofxViveTrackerDevice* getTrackerBySerial(const std::string& serial) const;
+
+	// Of the newest datagram, even if it was skipped waiting for a keyframe.
+	uint32_t getSequence() const;
+	// Datagrams applied.
+	uint64_t getReceivedPackets() const;
+	// Gaps in the sequence numbers, datagrams that never arrived.
+	uint64_t getLostPackets() const;
+	// Datagrams that arrived while waiting for a keyframe.
+	uint64_t getSkippedPackets() const;
+
+private:
+	// Datagrams read per receive call
+	static constexpr size_t batchSize = 16;
+
+	ofxViveTrackerUdpSocket socket;
+	ofxViveTrackerCodec codec;
+	std::vector<uint8_t> buffers;
+	size_t sizes[batchSize];
+
+	bool connected;
+	bool tracking;
+	float timeout;
+	bool haveSequence;
+	uint32_t sequence;
+	// The codec holds the state of the last datagram
+	bool synced;
+	uint64_t receivedPackets;
+	uint64_t lostPackets;
+	uint64_t skippedPackets;
+	std::chrono::steady_clock::time_point lastReceived;
+
+	std::vector<ofxViveTrackerDevice> trackers;
+	int slotForIndex[vr::k_unMaxTrackedDeviceCount];
+	std::unordered_map<std::string, size_t> slotForSerial;
+	ofxViveTrackerPublishedPose publishedPoses[vr::k_unMaxTrackedDeviceCount];
+
+	bool handlePacket(const uint8_t* data, size_t size, std::chrono::steady_clock::time_point now);
+	void rebuildMaps();
+	void disconnectAll();
+	void updateConnectionState();
+};
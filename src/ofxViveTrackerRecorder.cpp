@@ -0,0 +1,191 @@
+#include "ofxViveTrackerRecorder.h"
+#include "ofMain.h"
+
+ofxViveTrackerRecorder::ofxViveTrackerRecorder()
+	: header(nullptr)
+	, chunk(nullptr)
+	, chunkStart(0)
+	, count(0)
+	, chunkThreadRunning(false)
+	, preparedChunk(nullptr)
+	, prepareFailed(false)
+	, retiredChunk(nullptr) {
+}
+
+ofxViveTrackerRecorder::~ofxViveTrackerRecorder() {
+	close();
+}
+
+bool ofxViveTrackerRecorder::open(const std::string& path) {
+	close();
+	if (dataOffset % ofxViveTrackerMappedFile::getGranularity() != 0 ||
+		!file.open(ofToDataPath(path), ofxViveTrackerMappedFile::Mode::Write) ||
+		!file.resize(dataOffset)) {
+		ofLogError("ofxViveTrackerRecorder") << "Couldn't create " << path;
+		file.close();
+		return false;
+	}
+
+	header = (ofxViveTrackerRecordingHeader*)file.map(0, dataOffset);
+	if (!header) {
+		ofLogError("ofxViveTrackerRecorder") << "Couldn't map " << path;
+		file.close();
+		return false;
+	}
+
+	memset(header, 0, sizeof(*header));
+	memcpy(header->magic, ofxViveTrackerRecording::magic, sizeof(header->magic));
+	header->version = ofxViveTrackerRecording::version;
+	header->recordSize = sizeof(ofxViveTrackerRecord);
+	header->dataOffset = dataOffset;
+	header->recordCount = 0;
+	header->steadyStart = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	header->systemStart = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+	count = 0;
+	chunkStart = 0;
+	chunk = mapChunk(0);
+	if (!chunk) {
+		close();
+		return false;
+	}
+
+	preparedChunk = nullptr;
+	prepareFailed = false;
+	retiredChunk = nullptr;
+	chunkThreadRunning = true;
+	chunkThread = std::thread(&ofxViveTrackerRecorder::chunkThreadFunction, this);
+	return true;
+}
+
+void ofxViveTrackerRecorder::close() {
+	if (!file.isOpen()) return;
+
+	stopChunkThread();
+	if (preparedChunk) {
+		file.unmap(preparedChunk, chunkSize);
+		preparedChunk = nullptr;
+	}
+	if (retiredChunk) {
+		file.unmap(retiredChunk, chunkSize);
+		retiredChunk = nullptr;
+	}
+	if (header) {
+		header->recordCount = count;
+		file.unmap(header, dataOffset);
+		header = nullptr;
+	}
+	if (chunk) {
+		file.unmap(chunk, chunkSize);
+		chunk = nullptr;
+	}
+
+	// Drop the unused tail of the last chunk
+	file.resize(dataOffset + count * sizeof(ofxViveTrackerRecord));
+	file.close();
+}
+
+bool ofxViveTrackerRecorder::isOpen() const {
+	return chunk != nullptr;
+}
+
+void ofxViveTrackerRecorder::setSerial(vr::TrackedDeviceIndex_t index, const std::string& serial) {
+	if (!header || index >= vr::k_unMaxTrackedDeviceCount) return;
+	char* dest = header->serials[index];
+	size_t length = std::min(serial.size(), sizeof(header->serials[index]) - 1);
+	memcpy(dest, serial.data(), length);
+	dest[length] = '\0';
+}
+
+bool ofxViveTrackerRecorder::add(const ofxViveTrackerSample& sample) {
+	if (!chunk) return false;
+	if (count - chunkStart == recordsPerChunk && !nextChunk()) return false;
+
+	chunk[count - chunkStart] = ofxViveTrackerRecord::fromSample(sample);
+	count++;
+	header->recordCount = count;
+	return true;
+}
+
+bool ofxViveTrackerRecorder::add(const std::vector<ofxViveTrackerSample>& samples) {
+	for (const auto& sample : samples) {
+		if (!add(sample)) return false;
+	}
+	return true;
+}
+
+uint64_t ofxViveTrackerRecorder::size() const {
+	return count;
+}
+
+ofxViveTrackerRecord* ofxViveTrackerRecorder::mapChunk(uint64_t start) {
+	// Real blocks first: a store into a sparse mapping on a full disk is a
+	// SIGBUS rather than an error we could report
+	uint64_t offset = dataOffset + start * sizeof(ofxViveTrackerRecord);
+	if (!file.allocate(offset + chunkSize)) {
+		ofLogError("ofxViveTrackerRecorder") << "Couldn't grow recording, disk full?";
+		return nullptr;
+	}
+	ofxViveTrackerRecord* data = (ofxViveTrackerRecord*)file.map(offset, chunkSize);
+	if (!data) {
+		ofLogError("ofxViveTrackerRecorder") << "Couldn't map recording";
+		return nullptr;
+	}
+	// Take the page faults here rather than in add()
+	volatile char* bytes = (volatile char*)data;
+	for (size_t i = 0; i < chunkSize; i += ofxViveTrackerMappedFile::getGranularity()) {
+		bytes[i] = 0;
+	}
+	return data;
+}
+
+bool ofxViveTrackerRecorder::nextChunk() {
+	// Normally the helper thread is long done with the next chunk
+	std::unique_lock<std::mutex> lock(mutex);
+	condition.wait(lock, [this] { return preparedChunk || prepareFailed; });
+
+	// Out of space stops the recording, what is in the file so far stays
+	retiredChunk = chunk;
+	chunk = preparedChunk;
+	preparedChunk = nullptr;
+	if (chunk) {
+		chunkStart += recordsPerChunk;
+	}
+	lock.unlock();
+	condition.notify_all();
+	return chunk != nullptr;
+}
+
+void ofxViveTrackerRecorder::stopChunkThread() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		chunkThreadRunning = false;
+	}
+	condition.notify_all();
+	if (chunkThread.joinable()) {
+		chunkThread.join();
+	}
+}
+
+void ofxViveTrackerRecorder::chunkThreadFunction() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (chunkThreadRunning) {
+		if (retiredChunk) {
+			ofxViveTrackerRecord* retired = retiredChunk;
+			retiredChunk = nullptr;
+			lock.unlock();
+			file.unmap(retired, chunkSize);
+			lock.lock();
+		} else if (!preparedChunk && !prepareFailed) {
+			uint64_t start = chunkStart + recordsPerChunk;
+			lock.unlock();
+			ofxViveTrackerRecord* prepared = mapChunk(start);
+			lock.lock();
+			preparedChunk = prepared;
+			prepareFailed = !prepared;
+			condition.notify_all();
+		} else {
+			condition.wait(lock);
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ofxViveTrackerRecording.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Append-only writer for the ofxViveTrackerRecording format. The file is
+// grown and mapped in large chunks, so add() is a copy into the mapping
+// with no allocation and no system calls. A helper thread allocates and
+// maps the next chunk while the current one fills, and unmaps full ones,
+// so the thread calling add() only swaps pointers between chunks.
+class ofxViveTrackerRecorder {
+public:
+	ofxViveTrackerRecorder();
+	~ofxViveTrackerRecorder();
+
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const;
+
+	void setSerial(vr::TrackedDeviceIndex_t index, const std::string& serial);
+
+	bool add(const ofxViveTrackerSample& sample);
+	bool add(const std::vector<ofxViveTrackerSample>& samples);
+
+	uint64_t size() const;
+
+private:
+	// Records per chunk. Keeps every chunk offset a multiple of 64KB, the
+	// coarsest mapping granularity we have to support.
+	static const size_t recordsPerChunk = 65536;
+	static const size_t chunkSize = recordsPerChunk * sizeof(ofxViveTrackerRecord);
+	static const size_t dataOffset = 65536;
+
+	ofxViveTrackerMappedFile file;
+	ofxViveTrackerRecordingHeader* header;
+	ofxViveTrackerRecord* chunk;
+	uint64_t chunkStart;
+	uint64_t count;
+
+	// Handed between add() and the helper thread under mutex
+	std::thread chunkThread;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool chunkThreadRunning;
+	ofxViveTrackerRecord* preparedChunk; // Mapped at chunkStart + recordsPerChunk
+	bool prepareFailed;
+	ofxViveTrackerRecord* retiredChunk;  // Full, waiting to be unmapped
+
+	ofxViveTrackerRecord* mapChunk(uint64_t start);
+	bool nextChunk();
+	void stopChunkThread();
+	void chunkThreadFunction();
+};
@@ -0,0 +1,107 @@
+#include "ofxViveTrackerRecording.h"
+#include "ofMain.h"
+
+const char ofxViveTrackerRecording::magic[8] = { 'O', 'F', 'X', 'V', 'I', 'V', 'E', '\0' };
+
+ofxViveTrackerRecord ofxViveTrackerRecord::fromSample(const ofxViveTrackerSample& sample) {
+	ofxViveTrackerRecord record;
+	record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(sample.time.time_since_epoch()).count();
+	record.frame = sample.frame;
+	record.index = sample.index;
+	record.connected = sample.pose.bDeviceIsConnected;
+	record.valid = sample.pose.bPoseIsValid;
+	record.trackingResult = sample.pose.eTrackingResult;
+	memcpy(record.matrix, sample.pose.mDeviceToAbsoluteTracking.m, sizeof(record.matrix));
+	memcpy(record.velocity, sample.pose.vVelocity.v, sizeof(record.velocity));
+	memcpy(record.angularVelocity, sample.pose.vAngularVelocity.v, sizeof(record.angularVelocity));
+	return record;
+}
+
+ofxViveTrackerSample ofxViveTrackerRecord::toSample() const {
+	ofxViveTrackerSample sample;
+	sample.time = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(time)));
+	sample.frame = frame;
+	sample.index = index;
+	sample.pose.bDeviceIsConnected = connected != 0;
+	sample.pose.bPoseIsValid = valid != 0;
+	sample.pose.eTrackingResult = vr::ETrackingResult(trackingResult);
+	memcpy(sample.pose.mDeviceToAbsoluteTracking.m, matrix, sizeof(matrix));
+	memcpy(sample.pose.vVelocity.v, velocity, sizeof(velocity));
+	memcpy(sample.pose.vAngularVelocity.v, angularVelocity, sizeof(angularVelocity));
+	return sample;
+}
+
+ofxViveTrackerRecording::ofxViveTrackerRecording()
+	: mapping(nullptr)
+	, mappingSize(0)
+	, header(nullptr)
+	, records(nullptr)
+	, count(0) {
+}
+
+ofxViveTrackerRecording::~ofxViveTrackerRecording() {
+	close();
+}
+
+bool ofxViveTrackerRecording::open(const std::string& path) {
+	close();
+	if (!file.open(ofToDataPath(path), ofxViveTrackerMappedFile::Mode::Read)) {
+		ofLogError("ofxViveTrackerRecording") << "Couldn't open " << path;
+		return false;
+	}
+
+	mappingSize = file.getSize();
+	if (mappingSize < sizeof(ofxViveTrackerRecordingHeader)) {
+		ofLogError("ofxViveTrackerRecording") << path << " is not a recording";
+		close();
+		return false;
+	}
+	mapping = file.map(0, mappingSize);
+	header = (const ofxViveTrackerRecordingHeader*)mapping;
+	if (!header || memcmp(header->magic, magic, sizeof(magic)) != 0) {
+		ofLogError("ofxViveTrackerRecording") << path << " is not a recording";
+		close();
+		return false;
+	}
+	if (header->version != version || header->recordSize != sizeof(ofxViveTrackerRecord) || header->dataOffset > mappingSize) {
+		ofLogError("ofxViveTrackerRecording") << path << " has unsupported version " << header->version;
+		close();
+		return false;
+	}
+
+	// Trust the file size over the header if recording was interrupted
+	size_t available = (mappingSize - header->dataOffset) / sizeof(ofxViveTrackerRecord);
+	count = std::min<size_t>(header->recordCount, available);
+	records = (const ofxViveTrackerRecord*)((const char*)mapping + header->dataOffset);
+	return true;
+}
+
+void ofxViveTrackerRecording::close() {
+	file.unmap(mapping, mappingSize);
+	file.close();
+	mapping = nullptr;
+	mappingSize = 0;
+	header = nullptr;
+	records = nullptr;
+	count = 0;
+}
+
+bool ofxViveTrackerRecording::isOpen() const {
+	return header != nullptr;
+}
+
+const ofxViveTrackerRecordingHeader& ofxViveTrackerRecording::getHeader() const {
+	return *header;
+}
+
+size_t ofxViveTrackerRecording::size() const {
+	return count;
+}
+
+const ofxViveTrackerRecord* ofxViveTrackerRecording::data() const {
+	return records;
+}
+
+const ofxViveTrackerRecord& ofxViveTrackerRecording::operator[](size_t i) const {
+	return records[i];
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "ofxViveTrackerMappedFile.h"
+#include "ofxViveTrackerSource.h"
+
+// Binary recording format, version 1. All fields are little-endian and the
+// file is used in place through a memory mapping:
+//
+//   [0, dataOffset)                          ofxViveTrackerRecordingHeader
+//   [dataOffset, dataOffset + count * 96)    ofxViveTrackerRecord[count]
+//
+// Records are in the order they were sampled, so times are non-decreasing.
+
+struct ofxViveTrackerRecordingHeader {
+	char magic[8];          // "OFXVIVE\0"
+	uint32_t version;
+	uint32_t recordSize;
+	uint64_t dataOffset;
+	uint64_t recordCount;   // Kept current while recording
+	int64_t steadyStart;    // steady_clock nanoseconds when recording started
+	int64_t systemStart;    // system_clock nanoseconds at the same instant
+	char serials[64][32];   // Serial number of each device index, if known
+};
+
+struct ofxViveTrackerRecord {
+	int64_t time;           // steady_clock nanoseconds
+	uint64_t frame;         // OpenVR frame counter
+	uint32_t index;         // Device index
+	uint8_t connected;
+	uint8_t valid;
+	uint16_t trackingResult;
+	float matrix[3][4];     // HmdMatrix34_t, row major
+	float velocity[3];
+	float angularVelocity[3];
+
+	static ofxViveTrackerRecord fromSample(const ofxViveTrackerSample& sample);
+	ofxViveTrackerSample toSample() const;
+};
+
+static_assert(sizeof(ofxViveTrackerRecord) == 96, "ofxViveTrackerRecord layout changed");
+
+// Read-only view of a recording. Records are read straight from the mapping.
+class ofxViveTrackerRecording {
+public:
+	static const char magic[8];
+	static const uint32_t version = 1;
+
+	ofxViveTrackerRecording();
+	~ofxViveTrackerRecording();
+
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const;
+
+	const ofxViveTrackerRecordingHeader& getHeader() const;
+	size_t size() const;
+	const ofxViveTrackerRecord* data() const;
+	const ofxViveTrackerRecord& operator[](size_t i) const;
+
+private:
+	ofxViveTrackerMappedFile file;
+	void* mapping;
+	size_t mappingSize;
+	const ofxViveTrackerRecordingHeader* header;
+	const ofxViveTrackerRecord* records;
+	size_t count;
+};
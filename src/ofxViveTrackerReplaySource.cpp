@@ -0,0 +1,268 @@
+#include "ofxViveTrackerReplaySource.h"
+#include <algorithm>
+#include <cstring>
+
+ofxViveTrackerReplaySource::ofxViveTrackerReplaySource()
+	: records(nullptr)
+	, count(0)
+	, deviceMask(0)
+	, mode(Mode::RealTime)
+	, speed(1.0)
+	, paused(false)
+	, loop(false)
+	, playhead(0)
+	, cursor(0)
+	, finished(false) {
+	memset(current, 0, sizeof(current));
+	std::fill(std::begin(reportedConnected), std::end(reportedConnected), false);
+}
+
+bool ofxViveTrackerReplaySource::load(const std::string& path) {
+	ownedRecords.clear();
+	if (!recording.open(path)) {
+		setRecords(nullptr, 0);
+		return false;
+	}
+
+	for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+		const char* serial = recording.getHeader().serials[i];
+		serials[i] = std::string(serial, strnlen(serial, sizeof(recording.getHeader().serials[i])));
+	}
+	setRecords(recording.data(), recording.size());
+	return true;
+}
+
+void ofxViveTrackerReplaySource::load(const std::vector<ofxViveTrackerSample>& samples) {
+	recording.close();
+	ownedRecords.resize(samples.size());
+	for (size_t i = 0; i < samples.size(); i++) {
+		ownedRecords[i] = ofxViveTrackerRecord::fromSample(samples[i]);
+	}
+	setRecords(ownedRecords.data(), ownedRecords.size());
+}
+
+void ofxViveTrackerReplaySource::setRecords(const ofxViveTrackerRecord* data, size_t size) {
+	std::lock_guard<std::mutex> lock(mutex);
+	records = data;
+	count = size;
+
+	// One pass over everything: the devices in use, and a sparse index with
+	// the time of every indexStride-th record and the last record of every
+	// device before it, so a seek knows each device's state at any block
+	timeIndex.clear();
+	blockRecords.clear();
+	deviceMask = 0;
+	for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+		if (!serials[i].empty()) deviceMask |= uint64_t(1) << i;
+	}
+	uint64_t last[vr::k_unMaxTrackedDeviceCount] = {};
+	for (size_t i = 0; i < count; i++) {
+		if (i % indexStride == 0) {
+			timeIndex.push_back(records[i].time);
+			blockRecords.insert(blockRecords.end(), std::begin(last), std::end(last));
+		}
+		if (records[i].index < vr::k_unMaxTrackedDeviceCount) {
+			deviceMask |= uint64_t(1) << records[i].index;
+			last[records[i].index] = i + 1;
+		}
+	}
+}
+
+void ofxViveTrackerReplaySource::setMode(Mode m) {
+	std::lock_guard<std::mutex> lock(mutex);
+	mode = m;
+	lastUpdate = std::chrono::steady_clock::now();
+}
+
+void ofxViveTrackerReplaySource::setSpeed(double s) {
+	std::lock_guard<std::mutex> lock(mutex);
+	speed = std::max(s, 0.0);
+}
+
+void ofxViveTrackerReplaySource::setPaused(bool p) {
+	std::lock_guard<std::mutex> lock(mutex);
+	paused = p;
+	lastUpdate = std::chrono::steady_clock::now();
+}
+
+void ofxViveTrackerReplaySource::setLoop(bool enable) {
+	std::lock_guard<std::mutex> lock(mutex);
+	loop = enable;
+}
+
+void ofxViveTrackerReplaySource::setSerial(vr::TrackedDeviceIndex_t index, const std::string& serial) {
+	if (index < vr::k_unMaxTrackedDeviceCount) {
+		serials[index] = serial;
+	}
+}
+
+void ofxViveTrackerReplaySource::step(int frames) {
+	std::lock_guard<std::mutex> lock(mutex);
+	stepFrames(frames);
+}
+
+void ofxViveTrackerReplaySource::seek(double seconds) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (count == 0) return;
+	seekTo(records[0].time + int64_t(seconds * 1e9));
+	lastUpdate = std::chrono::steady_clock::now();
+}
+
+double ofxViveTrackerReplaySource::getTime() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (count == 0) return 0.0;
+	return (playhead - records[0].time) / 1e9;
+}
+
+double ofxViveTrackerReplaySource::getDuration() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (count == 0) return 0.0;
+	return (records[count - 1].time - records[0].time) / 1e9;
+}
+
+bool ofxViveTrackerReplaySource::isFinished() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return finished;
+}
+
+bool ofxViveTrackerReplaySource::connect() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (count == 0) return false;
+
+	seekTo(records[0].time);
+	lastUpdate = std::chrono::steady_clock::now();
+	for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+		reportedConnected[i] = current[i].bDeviceIsConnected;
+	}
+	return true;
+}
+
+void ofxViveTrackerReplaySource::disconnect() {
+}
+
+bool ofxViveTrackerReplaySource::isDeviceConnected(vr::TrackedDeviceIndex_t index) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return index < vr::k_unMaxTrackedDeviceCount && current[index].bDeviceIsConnected;
+}
+
+vr::ETrackedDeviceClass ofxViveTrackerReplaySource::getDeviceClass(vr::TrackedDeviceIndex_t index) {
+	if (index >= vr::k_unMaxTrackedDeviceCount || !((deviceMask >> index) & 1)) return vr::TrackedDeviceClass_Invalid;
+	return vr::TrackedDeviceClass_GenericTracker;
+}
+
+std::string ofxViveTrackerReplaySource::getStringProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop) {
+	if (prop != vr::Prop_SerialNumber_String || getDeviceClass(index) == vr::TrackedDeviceClass_Invalid) return "";
+	if (!serials[index].empty()) return serials[index];
+	return "REPLAY-" + std::to_string(index);
+}
+
+bool ofxViveTrackerReplaySource::getFloatProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop, float& value) {
+	return false;
+}
+
+bool ofxViveTrackerReplaySource::pollNextEvent(vr::VREvent_t& event) {
+	// Turn recorded connects and disconnects into device events
+	std::lock_guard<std::mutex> lock(mutex);
+	for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+		bool connected = current[i].bDeviceIsConnected;
+		if (connected == reportedConnected[i]) continue;
+		reportedConnected[i] = connected;
+		memset(&event, 0, sizeof(event));
+		event.eventType = connected ? vr::VREvent_TrackedDeviceActivated : vr::VREvent_TrackedDeviceDeactivated;
+		event.trackedDeviceIndex = i;
+		return true;
+	}
+	return false;
+}
+
+bool ofxViveTrackerReplaySource::getTimeSinceLastVsync(float& secondsSinceVsync, uint64_t& frame) {
+	return false;
+}
+
+void ofxViveTrackerReplaySource::getPoses(vr::ETrackingUniverseOrigin origin, float predictedSeconds, vr::TrackedDevicePose_t* poses, uint32_t n) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (count > 0 && !paused) {
+		if (mode == Mode::RealTime) {
+			auto now = std::chrono::steady_clock::now();
+			playhead += int64_t(std::chrono::duration<double, std::nano>(now - lastUpdate).count() * speed);
+			lastUpdate = now;
+			applyUntil(playhead);
+		} else if (mode == Mode::AsFastAsPossible) {
+			stepFrames(1);
+		}
+	}
+
+	memcpy(poses, current, sizeof(vr::TrackedDevicePose_t) * std::min(n, vr::k_unMaxTrackedDeviceCount));
+}
+
+size_t ofxViveTrackerReplaySource::findRecord(int64_t time) const {
+	// First record later than time: binary search the sparse index, then
+	// the one block of records it points to
+	size_t block = std::upper_bound(timeIndex.begin(), timeIndex.end(), time) - timeIndex.begin();
+	size_t begin = block == 0 ? 0 : (block - 1) * indexStride;
+	size_t end = std::min(count, block * indexStride);
+	auto later = [](int64_t t, const ofxViveTrackerRecord& record) {
+		return t < record.time;
+	};
+	return std::upper_bound(records + begin, records + end, time, later) - records;
+}
+
+void ofxViveTrackerReplaySource::seekTo(int64_t time) {
+	size_t position = findRecord(time);
+
+	// Rebuild the state at the playhead: every device as of the start of
+	// its block, then the records of the block up to the playhead
+	memset(current, 0, sizeof(current));
+	size_t block = std::min(position, count - 1) / indexStride;
+	const uint64_t* last = &blockRecords[block * vr::k_unMaxTrackedDeviceCount];
+	for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+		if (last[i]) apply(records[last[i] - 1]);
+	}
+	for (size_t i = block * indexStride; i < position; i++) {
+		apply(records[i]);
+	}
+
+	cursor = position;
+	playhead = time;
+	finished = false;
+}
+
+void ofxViveTrackerReplaySource::applyUntil(int64_t time) {
+	while (cursor < count && records[cursor].time <= time) {
+		apply(records[cursor++]);
+	}
+
+	if (cursor == count) {
+		int64_t duration = records[count - 1].time - records[0].time;
+		if (loop && duration > 0) {
+			playhead = records[0].time + (playhead - records[count - 1].time) % duration;
+			cursor = 0;
+			applyUntil(playhead);
+		} else {
+			finished = true;
+		}
+	}
+}
+
+void ofxViveTrackerReplaySource::stepFrames(int frames) {
+	for (int i = 0; i < frames && count > 0; i++) {
+		if (cursor == count) {
+			if (!loop) {
+				finished = true;
+				return;
+			}
+			cursor = 0;
+		}
+		playhead = records[cursor].time;
+		while (cursor < count && records[cursor].time == playhead) {
+			apply(records[cursor++]);
+		}
+	}
+}
+
+void ofxViveTrackerReplaySource::apply(const ofxViveTrackerRecord& record) {
+	if (record.index < vr::k_unMaxTrackedDeviceCount) {
+		current[record.index] = record.toSample().pose;
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ofxViveTrackerRecording.h"
+#include "ofxViveTrackerSource.h"
+#include <mutex>
+#include <vector>
+
+// Plays back a recording, or samples collected from
+// ofxViveTracker::getSamples(), through ofxViveTracker as if they came from
+// SteamVR. Every device index in the data shows up as a GenericTracker, and
+// recorded connects and disconnects become device events. Prediction is
+// ignored: a replay can only return what was recorded.
+//
+// Recordings are played straight from their memory mapping. Seeking uses a
+// sparse in-memory time index and then a binary search inside one block of
+// the file, so it is O(log n) and touches only a few pages. The index also
+// holds the last record of every device before each block, so devices that
+// were silent for a long time come back in the state they were left in.
+// Loading reads the whole recording once to build it.
+class ofxViveTrackerReplaySource : public ofxViveTrackerSource {
+public:
+	enum class Mode {
+		RealTime,        // Follow steady_clock, scaled by setSpeed()
+		Step,            // Only advance on step()
+		AsFastAsPossible // Advance one recorded frame per getPoses()
+	};
+
+	ofxViveTrackerReplaySource();
+
+	// Call before setup().
+	bool load(const std::string& path);
+	// Samples must be sorted by time. Call before setup().
+	void load(const std::vector<ofxViveTrackerSample>& samples);
+
+	void setMode(Mode mode);
+	void setSpeed(double speed);
+	void setPaused(bool paused);
+	void setLoop(bool loop);
+	void setSerial(vr::TrackedDeviceIndex_t index, const std::string& serial);
+
+	// Advance by whole recorded frames (records sharing a timestamp).
+	void step(int frames = 1);
+	// Jump to seconds since the start of the recording.
+	void seek(double seconds);
+
+	double getTime() const;
+	double getDuration() const;
+	bool isFinished() const;
+
+	bool connect() override;
+	void disconnect() override;
+
+	bool isDeviceConnected(vr::TrackedDeviceIndex_t index) override;
+	vr::ETrackedDeviceClass getDeviceClass(vr::TrackedDeviceIndex_t index) override;
+	std::string getStringProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop) override;
+	bool getFloatProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop, float& value) override;
+
+	bool pollNextEvent(vr::VREvent_t& event) override;
+	bool getTimeSinceLastVsync(float& secondsSinceVsync, uint64_t& frame) override;
+	void getPoses(vr::ETrackingUniverseOrigin origin, float predictedSeconds, vr::TrackedDevicePose_t* poses, uint32_t count) override;
+
+private:
+	static constexpr size_t indexStride = 4096;
+
+	ofxViveTrackerRecording recording;
+	std::vector<ofxViveTrackerRecord> ownedRecords;
+	const ofxViveTrackerRecord* records;
+	size_t count;
+	std::vector<int64_t> timeIndex;
+	// Per block, one past the last record of each device before it, or 0
+	std::vector<uint64_t> blockRecords;
+	std::string serials[vr::k_unMaxTrackedDeviceCount];
+	uint64_t deviceMask;
+
+	mutable std::mutex mutex;
+	Mode mode;
+	double speed;
+	bool paused;
+	bool loop;
+
+	int64_t playhead;
+	std::chrono::steady_clock::time_point lastUpdate;
+	size_t cursor;
+	bool finished;
+	vr::TrackedDevicePose_t current[vr::k_unMaxTrackedDeviceCount];
+	bool reportedConnected[vr::k_unMaxTrackedDeviceCount];
+
+	void setRecords(const ofxViveTrackerRecord* data, size_t size);
+	size_t findRecord(int64_t time) const;
+	void seekTo(int64_t time);
+	void applyUntil(int64_t time);
+	void stepFrames(int frames);
+	void apply(const ofxViveTrackerRecord& record);
+};
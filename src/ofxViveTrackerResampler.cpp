@@ -0,0 +1,103 @@
+#include "ofxViveTrackerResampler.h"
+
+ofxViveTrackerResampler::ofxViveTrackerResampler()
+	: rate(0.0f)
+	, interpolation(Interpolation::Hermite)
+	, maxTicks(0)
+	, started(false)
+	, nextTick(0)
+	, skippedTicks(0) {
+}
+
+void ofxViveTrackerResampler::setup(float r, Interpolation mode, float maxBatch) {
+	rate = std::max(r, 1.0f);
+	interpolation = mode;
+	maxTicks = std::max<uint64_t>(1, uint64_t(rate * maxBatch));
+	// A full batch of a few trackers without growing
+	poses.clear();
+	poses.reserve(size_t(maxTicks) * 4);
+	reset();
+}
+
+void ofxViveTrackerResampler::reset() {
+	started = false;
+	nextTick = 0;
+	skippedTicks = 0;
+	poses.clear();
+}
+
+float ofxViveTrackerResampler::getRate() const {
+	return rate;
+}
+
+std::chrono::steady_clock::time_point ofxViveTrackerResampler::getTickTime(uint64_t tick) const {
+	// From the start each time, so the spacing never drifts
+	return start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(tick / double(rate)));
+}
+
+const std::vector<ofxViveTrackerResampledPose>& ofxViveTrackerResampler::update(const ofxViveTracker& tracker) {
+	poses.clear();
+	if (rate <= 0.0f) return poses;
+
+	const ofxViveTrackerPoseHistory& history = tracker.getHistory();
+	size_t numSlots = std::min<size_t>(tracker.getNumTrackers(), ofxViveTrackerPoseHistory::maxSlots);
+	std::chrono::steady_clock::time_point newest[ofxViveTrackerPoseHistory::maxSlots];
+	bool haveNewest[ofxViveTrackerPoseHistory::maxSlots];
+	bool any = false;
+	std::chrono::steady_clock::time_point latest;
+	for (size_t slot = 0; slot < numSlots; slot++) {
+		ofxViveTrackerRawPose pose;
+		haveNewest[slot] = history.getNewest(slot, pose);
+		if (!haveNewest[slot]) continue;
+		newest[slot] = pose.time;
+		latest = any ? std::max(latest, pose.time) : pose.time;
+		any = true;
+	}
+	if (!any) return poses;
+
+	if (!started) {
+		start = latest;
+		nextTick = 0;
+		started = true;
+	}
+	if (latest < start) return poses;
+
+	uint64_t lastTick = uint64_t(std::chrono::duration<double>(latest - start).count() * rate);
+	if (getTickTime(lastTick) > latest) {
+		lastTick--;
+	}
+	if (lastTick + 1 < nextTick) return poses;
+	if (lastTick + 1 - nextTick > maxTicks) {
+		skippedTicks += lastTick + 1 - maxTicks - nextTick;
+		nextTick = lastTick + 1 - maxTicks;
+	}
+
+	auto extrapolation = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(maxExtrapolation));
+	for (; nextTick <= lastTick; nextTick++) {
+		auto time = getTickTime(nextTick);
+		for (size_t slot = 0; slot < numSlots; slot++) {
+			ofxViveTrackerResampledPose resampled;
+			resampled.tick = nextTick;
+			resampled.slot = slot;
+			if (haveNewest[slot]) {
+				resampled.pose = history.getPoseAt(slot, time, interpolation, maxExtrapolation);
+				resampled.pose.tracking = resampled.pose.tracking && time <= newest[slot] + extrapolation;
+			}
+			resampled.pose.time = time;
+			poses.push_back(resampled);
+		}
+	}
+	return poses;
+}
+
+const std::vector<ofxViveTrackerResampledPose>& ofxViveTrackerResampler::getPoses() const {
+	return poses;
+}
+
+uint64_t ofxViveTrackerResampler::getNextTick() const {
+	return nextTick;
+}
+
+uint64_t ofxViveTrackerResampler::getSkippedTicks() const {
+	return skippedTicks;
+}
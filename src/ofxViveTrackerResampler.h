@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ofxViveTracker.h"
+
+// One tracker's pose at one tick of the resampled stream.
+struct ofxViveTrackerResampledPose {
+	uint64_t tick;
+	size_t slot;
+	// pose.time is the tick's time
+	ofxViveTrackerPose pose;
+};
+
+// Turns the irregular pose stream into one at an exact rate: every 1/rate
+// seconds, the pose of every tracker at that instant, interpolated from
+// the tracker's history (enable it with ofxViveTracker::setHistorySize(),
+// covering at least a frame's worth of poses).
+//
+// Call update() after ofxViveTracker::update(). It returns every tick
+// that came due since the previous call as one batch, ticks in order and
+// slots in order within a tick. A tick is due once some tracker has a
+// pose at or after it, so the output trails the newest pose by less than
+// a period. A tracker that stopped reporting is extrapolated briefly, then
+// comes out not tracking.
+class ofxViveTrackerResampler {
+public:
+	using Interpolation = ofxViveTrackerPoseHistory::Interpolation;
+
+	// How long a silent tracker is extrapolated for.
+	static constexpr float maxExtrapolation = 0.05f;
+
+	ofxViveTrackerResampler();
+
+	// rate in Hz. After a stall longer than maxBatch seconds only the most
+	// recent maxBatch seconds are emitted and the rest counted as skipped.
+	void setup(float rate, Interpolation interpolation = Interpolation::Hermite, float maxBatch = 1.0f);
+	// Starts the tick count over at the next update().
+	void reset();
+
+	float getRate() const;
+	std::chrono::steady_clock::time_point getTickTime(uint64_t tick) const;
+
+	const std::vector<ofxViveTrackerResampledPose>& update(const ofxViveTracker& tracker);
+	// The batch of the last update().
+	const std::vector<ofxViveTrackerResampledPose>& getPoses() const;
+	// First tick the next update() will emit.
+	uint64_t getNextTick() const;
+	uint64_t getSkippedTicks() const;
+
+private:
+	float rate;
+	Interpolation interpolation;
+	uint64_t maxTicks;
+
+	bool started;
+	std::chrono::steady_clock::time_point start;
+	uint64_t nextTick;
+	uint64_t skippedTicks;
+	std::vector<ofxViveTrackerResampledPose> poses;
+};
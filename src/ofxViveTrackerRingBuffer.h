@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Single-producer/single-consumer lock-free ring. push() may only be called
+// from one thread and pop() from one other thread. Capacity is rounded up to
+// a power of two; allocate() must be called while neither side is running.
+template<typename T>
+class ofxViveTrackerRingBuffer {
+public:
+	ofxViveTrackerRingBuffer()
+		: mask(0)
+		, head(0)
+		, tail(0) {
+	}
+
+	void allocate(size_t capacity) {
+		size_t size = 1;
+		while (size < capacity) size <<= 1;
+		buffer.assign(size, T());
+		mask = size - 1;
+		head.store(0, std::memory_order_relaxed);
+		tail.store(0, std::memory_order_relaxed);
+	}
+
+	// Returns false without blocking when the ring is full.
+	bool push(const T& item) {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h - tail.load(std::memory_order_acquire) >= buffer.size()) return false;
+		buffer[h & mask] = item;
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Returns false without blocking when the ring is empty.
+	bool pop(T& item) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (t == head.load(std::memory_order_acquire)) return false;
+		item = buffer[t & mask];
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t size() const {
+		return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+	}
+
+	size_t capacity() const {
+		return buffer.size();
+	}
+
+private:
+	std::vector<T> buffer;
+	size_t mask;
+
+	// Keep the producer and consumer indices on separate cache lines
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+};
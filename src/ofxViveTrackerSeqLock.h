@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer sequence lock. store() never blocks; load() retries until it
+// copies a value no store() overlapped, so readers on any thread always see
+// one whole sample without taking a mutex or allocating.
+template<typename T>
+class ofxViveTrackerSeqLock {
+	static_assert(std::is_trivially_copyable<T>::value, "ofxViveTrackerSeqLock requires a trivially copyable type");
+
+public:
+	ofxViveTrackerSeqLock()
+		: sequence(0) {
+	}
+
+	// Only one thread may call store().
+	void store(const T& value) {
+		unsigned s = sequence.load(std::memory_order_relaxed);
+		sequence.store(s + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		std::memcpy(&data, &value, sizeof(T));
+		sequence.store(s + 2, std::memory_order_release);
+	}
+
+	T load() const {
+		T value;
+		unsigned before, after;
+		do {
+			before = sequence.load(std::memory_order_acquire);
+			std::memcpy(&value, &data, sizeof(T));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = sequence.load(std::memory_order_relaxed);
+		} while ((before & 1) || before != after);
+		return value;
+	}
+
+	// Single attempt: false if a store() was in progress, so readers can
+	// give up instead of spinning on a writer that may never finish (for
+	// example one in another process that died).
+	bool tryLoad(T& value) const {
+		unsigned before = sequence.load(std::memory_order_acquire);
+		if (before & 1) return false;
+		std::memcpy(&value, &data, sizeof(T));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return sequence.load(std::memory_order_relaxed) == before;
+	}
+
+private:
+	std::atomic<unsigned> sequence;
+	T data;
+};
@@ -0,0 +1,202 @@
+#include "ofxViveTrackerSharedMemory.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+ofxViveTrackerSharedMemory::ofxViveTrackerSharedMemory()
+	: owner(false)
+	, data(nullptr)
+	, size(0)
+	, mapping(nullptr) {
+}
+
+ofxViveTrackerSharedMemory::~ofxViveTrackerSharedMemory() {
+	close();
+}
+
+bool ofxViveTrackerSharedMemory::create(const std::string& n, size_t s) {
+	close();
+	// Session-local names need no special privileges
+	std::string path = "Local\\" + n;
+	uint64_t size64 = s;
+	mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD) (size64 >> 32), (DWORD) size64, path.c_str());
+	if (!mapping) return false;
+	if (GetLastError() == ERROR_ALREADY_EXISTS) {
+		// Still held open by another process, and may be smaller
+		CloseHandle(mapping);
+		mapping = nullptr;
+		return false;
+	}
+	data = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, s);
+	if (!data) {
+		close();
+		return false;
+	}
+	name = n;
+	owner = true;
+	size = s;
+	return true;
+}
+
+bool ofxViveTrackerSharedMemory::open(const std::string& n) {
+	close();
+	std::string path = "Local\\" + n;
+	mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, path.c_str());
+	if (!mapping) return false;
+	data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		close();
+		return false;
+	}
+	MEMORY_BASIC_INFORMATION info;
+	VirtualQuery(data, &info, sizeof(info));
+	name = n;
+	owner = false;
+	size = info.RegionSize;
+	return true;
+}
+
+void ofxViveTrackerSharedMemory::close() {
+	if (data) {
+		UnmapViewOfFile(data);
+		data = nullptr;
+	}
+	if (mapping) {
+		// The mapping goes away with its last handle
+		CloseHandle(mapping);
+		mapping = nullptr;
+	}
+	owner = false;
+	size = 0;
+}
+
+#else
+
+// Whether path still names the region open as fd
+static bool isNamed(const std::string& path, int fd) {
+	int named = shm_open(path.c_str(), O_RDONLY, 0);
+	if (named < 0) return false;
+	struct stat a, b;
+	bool same = fstat(fd, &a) == 0 && fstat(named, &b) == 0 && a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+	::close(named);
+	return same;
+}
+
+ofxViveTrackerSharedMemory::ofxViveTrackerSharedMemory()
+	: owner(false)
+	, data(nullptr)
+	, size(0)
+	, fd(-1) {
+}
+
+ofxViveTrackerSharedMemory::~ofxViveTrackerSharedMemory() {
+	close();
+}
+
+bool ofxViveTrackerSharedMemory::create(const std::string& n, size_t s) {
+	close();
+	std::string path = "/" + n;
+	fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0 && errno == EEXIST) {
+		// Only take the name over if nobody holds the lock on it any more
+		int old = shm_open(path.c_str(), O_RDWR, 0);
+		if (old < 0) return false;
+		bool stale = flock(old, LOCK_EX | LOCK_NB) == 0;
+		if (stale) {
+			shm_unlink(path.c_str());
+		}
+		::close(old);
+		if (!stale) return false;
+		fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	}
+	if (fd < 0) return false;
+	// Another creator may have found it unlocked and taken the name over
+	if (flock(fd, LOCK_EX | LOCK_NB) != 0 || !isNamed(path, fd)) {
+		::close(fd);
+		fd = -1;
+		return false;
+	}
+	if (ftruncate(fd, s) != 0) {
+		::close(fd);
+		fd = -1;
+		shm_unlink(path.c_str());
+		return false;
+	}
+	void* mapped = mmap(nullptr, s, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (mapped == MAP_FAILED) {
+		::close(fd);
+		fd = -1;
+		shm_unlink(path.c_str());
+		return false;
+	}
+	name = n;
+	owner = true;
+	data = mapped;
+	size = s;
+	return true;
+}
+
+bool ofxViveTrackerSharedMemory::open(const std::string& n) {
+	close();
+	std::string path = "/" + n;
+	int file = shm_open(path.c_str(), O_RDONLY, 0);
+	if (file < 0) return false;
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size <= 0) {
+		::close(file);
+		return false;
+	}
+	void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+	::close(file);
+	if (mapped == MAP_FAILED) return false;
+	name = n;
+	owner = false;
+	data = mapped;
+	size = info.st_size;
+	return true;
+}
+
+void ofxViveTrackerSharedMemory::close() {
+	if (data) {
+		munmap(data, size);
+		data = nullptr;
+	}
+	if (owner) {
+		// Readers keep their mappings, only the name goes
+		shm_unlink(("/" + name).c_str());
+	}
+	if (fd >= 0) {
+		// Drops the lock
+		::close(fd);
+		fd = -1;
+	}
+	owner = false;
+	size = 0;
+}
+
+#endif
+
+bool ofxViveTrackerSharedMemory::isOpen() const {
+	return data != nullptr;
+}
+
+void* ofxViveTrackerSharedMemory::getData() const {
+	return data;
+}
+
+size_t ofxViveTrackerSharedMemory::getSize() const {
+	return size;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Minimal named shared memory, POSIX shm_open or Win32 named file mappings
+// backed by the paging file. A name belongs to its creator for as long as
+// the creator keeps it open, on both platforms: on POSIX the creator holds
+// a lock on the region, which the system drops if the process dies.
+class ofxViveTrackerSharedMemory {
+public:
+	ofxViveTrackerSharedMemory();
+	~ofxViveTrackerSharedMemory();
+
+	// Creates a new zero-filled region, read-write. Fails while another
+	// creator holds the name; on POSIX a region left behind by a process
+	// that died is replaced.
+	bool create(const std::string& name, size_t size);
+	// Maps an existing region read-only.
+	bool open(const std::string& name);
+	// Unmaps; the creator also removes the name.
+	void close();
+	bool isOpen() const;
+
+	void* getData() const;
+	size_t getSize() const;
+
+private:
+	std::string name;
+	bool owner;
+	void* data;
+	size_t size;
+#ifdef _WIN32
+	void* mapping;
+#else
+	// Kept open for the creator's lock
+	int fd;
+#endif
+
+	ofxViveTrackerSharedMemory(const ofxViveTrackerSharedMemory&) = delete;
+	ofxViveTrackerSharedMemory& operator=(const ofxViveTrackerSharedMemory&) = delete;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OFXVIVETRACKER_SSE2
+#endif
+
+namespace ofxViveTrackerSimd {
+
+// Four floats processed together, SSE2 where available and plain arrays
+// otherwise, so kernels across trackers are written once. Comparisons
+// return lane masks (all bits set or clear) for select().
+struct Float4 {
+#ifdef OFXVIVETRACKER_SSE2
+	__m128 v;
+
+	Float4() {}
+	Float4(__m128 v) : v(v) {}
+	explicit Float4(float s) : v(_mm_set1_ps(s)) {}
+
+	// p must be 16-byte aligned.
+	static Float4 load(const float* p) { return _mm_load_ps(p); }
+	void store(float* p) const { _mm_store_ps(p, v); }
+	static Float4 loadUnaligned(const float* p) { return _mm_loadu_ps(p); }
+	void storeUnaligned(float* p) const { _mm_storeu_ps(p, v); }
+#else
+	float v[4];
+
+	Float4() {}
+	explicit Float4(float s) { v[0] = v[1] = v[2] = v[3] = s; }
+
+	static Float4 load(const float* p) { Float4 r; memcpy(r.v, p, sizeof(r.v)); return r; }
+	void store(float* p) const { memcpy(p, v, sizeof(v)); }
+	static Float4 loadUnaligned(const float* p) { return load(p); }
+	void storeUnaligned(float* p) const { store(p); }
+#endif
+};
+
+#ifdef OFXVIVETRACKER_SSE2
+
+inline Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+inline Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+inline Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+inline Float4 operator/(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+inline Float4 operator-(Float4 a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+inline Float4 operator<(Float4 a, Float4 b) { return _mm_cmplt_ps(a.v, b.v); }
+inline Float4 operator>(Float4 a, Float4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline Float4 operator&(Float4 a, Float4 b) { return _mm_and_ps(a.v, b.v); }
+inline Float4 operator|(Float4 a, Float4 b) { return _mm_or_ps(a.v, b.v); }
+inline Float4 operator^(Float4 a, Float4 b) { return _mm_xor_ps(a.v, b.v); }
+inline Float4 minimum(Float4 a, Float4 b) { return _mm_min_ps(a.v, b.v); }
+inline Float4 maximum(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+inline Float4 sqrt(Float4 a) { return _mm_sqrt_ps(a.v); }
+inline Float4 abs(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+// Sign bit of a, to flip the sign of other values with ^
+inline Float4 signBit(Float4 a) { return _mm_and_ps(a.v, _mm_set1_ps(-0.0f)); }
+// mask ? a : b per lane
+inline Float4 select(Float4 mask, Float4 a, Float4 b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+inline bool any(Float4 mask) { return _mm_movemask_ps(mask.v) != 0; }
+// Rows become columns
+inline void transpose(Float4& a, Float4& b, Float4& c, Float4& d) { _MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v); }
+
+#else
+
+namespace detail {
+	inline uint32_t bits(float f) { uint32_t u; memcpy(&u, &f, sizeof(u)); return u; }
+	inline float fromBits(uint32_t u) { float f; memcpy(&f, &u, sizeof(f)); return f; }
+	template<class Op> inline Float4 map(Float4 a, Float4 b, Op op) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = op(a.v[i], b.v[i]); return r; }
+	template<class Op> inline Float4 mapBits(Float4 a, Float4 b, Op op) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = fromBits(op(bits(a.v[i]), bits(b.v[i]))); return r; }
+	inline float mask(bool b) { return fromBits(b ? 0xffffffffu : 0u); }
+}
+
+inline Float4 operator+(Float4 a, Float4 b) { return detail::map(a, b, [](float x, float y) { return x + y; }); }
+inline Float4 operator-(Float4 a, Float4 b) { return detail::map(a, b, [](float x, float y) { return x - y; }); }
+inline Float4 operator*(Float4 a, Float4 b) { return detail::map(a, b, [](float x, float y) { return x * y; }); }
+inline Float4 operator/(Float4 a, Float4 b) { return detail::map(a, b, [](float x, float y) { return x / y; }); }
+inline Float4 operator-(Float4 a) { return Float4(0.0f) - a; }
+inline Float4 operator<(Float4 a, Float4 b) { return detail::map(a, b, [](float x, float y) { return detail::mask(x < y); }); }
+inline Float4 operator>(Float4 a, Float4 b) { return detail::map(a, b, [](float x, float y) { return detail::mask(x > y); }); }
+inline Float4 operator&(Float4 a, Float4 b) { return detail::mapBits(a, b, [](uint32_t x, uint32_t y) { return x & y; }); }
+inline Float4 operator|(Float4 a, Float4 b) { return detail::mapBits(a, b, [](uint32_t x, uint32_t y) { return x | y; }); }
+inline Float4 operator^(Float4 a, Float4 b) { return detail::mapBits(a, b, [](uint32_t x, uint32_t y) { return x ^ y; }); }
+inline Float4 minimum(Float4 a, Float4 b) { return detail::map(a, b, [](float x, float y) { return y < x ? y : x; }); }
+inline Float4 maximum(Float4 a, Float4 b) { return detail::map(a, b, [](float x, float y) { return x < y ? y : x; }); }
+inline Float4 sqrt(Float4 a) { return detail::map(a, a, [](float x, float) { return std::sqrt(x); }); }
+inline Float4 abs(Float4 a) { return detail::map(a, a, [](float x, float) { return std::fabs(x); }); }
+inline Float4 signBit(Float4 a) { return a & Float4(-0.0f); }
+inline Float4 select(Float4 mask, Float4 a, Float4 b) { return (mask & a) | detail::mapBits(mask, b, [](uint32_t m, uint32_t y) { return ~m & y; }); }
+inline bool any(Float4 mask) { for (int i = 0; i < 4; i++) if (detail::bits(mask.v[i])) return true; return false; }
+inline void transpose(Float4& a, Float4& b, Float4& c, Float4& d) {
+	Float4* rows[4] = { &a, &b, &c, &d };
+	for (int i = 0; i < 4; i++) {
+		for (int j = i + 1; j < 4; j++) {
+			std::swap(rows[i]->v[j], rows[j]->v[i]);
+		}
+	}
+}
+
+#endif
+
+}
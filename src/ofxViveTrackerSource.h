@@ -0,0 +1,46 @@
+#pragma once
+
+#include <openvr.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// One raw pose of one device, as produced by a source.
+struct ofxViveTrackerSample {
+	std::chrono::steady_clock::time_point time;
+	uint64_t frame;
+	vr::TrackedDeviceIndex_t index;
+	vr::TrackedDevicePose_t pose;
+};
+
+// Where ofxViveTracker gets its devices and poses from. The interface
+// mirrors the parts of IVRSystem the tracker uses so that OpenVR, synthetic
+// and replayed data all look the same to everything above it.
+//
+// connect() and disconnect() are called from the connect thread while no
+// other method is in use. getPoses() is called from one thread at a time
+// (the update() thread, or the pose thread in threaded mode). The property
+// getters may also be called from the property cache thread, concurrently
+// with the others. Everything else is called from the update() thread.
+class ofxViveTrackerSource {
+public:
+	virtual ~ofxViveTrackerSource() {}
+
+	// May block, for example while SteamVR starts.
+	virtual bool connect() = 0;
+	virtual void disconnect() = 0;
+
+	virtual bool isDeviceConnected(vr::TrackedDeviceIndex_t index) = 0;
+	virtual vr::ETrackedDeviceClass getDeviceClass(vr::TrackedDeviceIndex_t index) = 0;
+	// Empty string if the device doesn't have the property.
+	virtual std::string getStringProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop) = 0;
+	virtual bool getFloatProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop, float& value) = 0;
+
+	virtual bool pollNextEvent(vr::VREvent_t& event) = 0;
+	virtual bool getTimeSinceLastVsync(float& secondsSinceVsync, uint64_t& frame) = 0;
+	// Fills poses[0..count) indexed by device index.
+	virtual void getPoses(vr::ETrackingUniverseOrigin origin, float predictedSeconds, vr::TrackedDevicePose_t* poses, uint32_t count) = 0;
+	// When the poses of the last getPoses() were fetched, for sources that
+	// can hand out poses fetched before the call. False to use the call time.
+	virtual bool getPosesFetchTime(std::chrono::steady_clock::time_point& time) { return false; }
+};
@@ -0,0 +1,224 @@
+#include "ofxViveTrackerSyntheticSource.h"
+#include "ofxViveTrackerMath.h"
+
+ofxViveTrackerSyntheticSource::ofxViveTrackerSyntheticSource()
+	: numDevices(1)
+	, rate(1000.0f)
+	, displayFrequency(90.0f)
+	, stepped(false)
+	, trajectory(&ofxViveTrackerSyntheticSource::circle)
+	, noise(0.0f)
+	, seed(0)
+	, quitTime(-1.0)
+	, connectFailures(0)
+	, step(0)
+	, quitSent(false) {
+	std::fill(std::begin(reportedConnected), std::end(reportedConnected), false);
+}
+
+void ofxViveTrackerSyntheticSource::setNumDevices(int count) {
+	numDevices = std::max(0, std::min(count, (int)vr::k_unMaxTrackedDeviceCount));
+}
+
+void ofxViveTrackerSyntheticSource::setRate(float hz) {
+	rate = std::max(hz, 1.0f);
+}
+
+void ofxViveTrackerSyntheticSource::setDisplayFrequency(float hz) {
+	displayFrequency = hz;
+}
+
+void ofxViveTrackerSyntheticSource::setStepped(bool enable) {
+	stepped = enable;
+}
+
+void ofxViveTrackerSyntheticSource::setTrajectory(Trajectory t) {
+	trajectory = t ? t : Trajectory(&ofxViveTrackerSyntheticSource::circle);
+}
+
+void ofxViveTrackerSyntheticSource::setNoise(float meters, uint32_t s) {
+	noise = meters;
+	seed = s;
+}
+
+void ofxViveTrackerSyntheticSource::addDropout(vr::TrackedDeviceIndex_t index, double start, double duration) {
+	dropouts.push_back({ index, start, start + duration });
+}
+
+void ofxViveTrackerSyntheticSource::addDisconnect(vr::TrackedDeviceIndex_t index, double start, double duration) {
+	disconnects.push_back({ index, start, start + duration });
+}
+
+void ofxViveTrackerSyntheticSource::setQuitTime(double seconds) {
+	quitTime = seconds;
+}
+
+void ofxViveTrackerSyntheticSource::setConnectFailures(int count) {
+	connectFailures = count;
+}
+
+double ofxViveTrackerSyntheticSource::getTime() const {
+	return getSampleNumber() / double(rate);
+}
+
+ofxViveTrackerSyntheticSource::State ofxViveTrackerSyntheticSource::circle(vr::TrackedDeviceIndex_t index, double seconds) {
+	float radius = 0.3f + 0.05f * (index % 8);
+	float speed = 0.5f + 0.1f * (index % 16);
+	float height = -1.0f - 0.1f * (index / 8);
+	float angle = float(index * 0.7 + speed * seconds);
+
+	State state;
+	state.position = glm::vec3(radius * std::cos(angle), height + 0.1f * std::sin(2.0f * angle), radius * std::sin(angle));
+	state.velocity = glm::vec3(-radius * speed * std::sin(angle), 0.2f * speed * std::cos(2.0f * angle), radius * speed * std::cos(angle));
+	state.orientation = glm::angleAxis(-angle, glm::vec3(0.0f, 1.0f, 0.0f));
+	state.angularVelocity = glm::vec3(0.0f, -speed, 0.0f);
+	return state;
+}
+
+bool ofxViveTrackerSyntheticSource::connect() {
+	if (connectFailures > 0) {
+		connectFailures--;
+		return false;
+	}
+
+	startTime = std::chrono::steady_clock::now();
+	step = 0;
+	quitSent = false;
+	for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+		reportedConnected[i] = isConnectedAt(i, 0.0);
+	}
+	return true;
+}
+
+void ofxViveTrackerSyntheticSource::disconnect() {
+}
+
+bool ofxViveTrackerSyntheticSource::isDeviceConnected(vr::TrackedDeviceIndex_t index) {
+	return isConnectedAt(index, getTime());
+}
+
+vr::ETrackedDeviceClass ofxViveTrackerSyntheticSource::getDeviceClass(vr::TrackedDeviceIndex_t index) {
+	return isDeviceConnected(index) ? vr::TrackedDeviceClass_GenericTracker : vr::TrackedDeviceClass_Invalid;
+}
+
+std::string ofxViveTrackerSyntheticSource::getStringProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop) {
+	if ((int)index >= numDevices) return "";
+	switch (prop) {
+	case vr::Prop_SerialNumber_String: {
+		char serial[16];
+		snprintf(serial, sizeof(serial), "SYNTH-%02u", index);
+		return serial;
+	}
+	case vr::Prop_ModelNumber_String:
+		return "Synthetic Tracker";
+	default:
+		return "";
+	}
+}
+
+bool ofxViveTrackerSyntheticSource::getFloatProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop, float& value) {
+	switch (prop) {
+	case vr::Prop_DisplayFrequency_Float:
+		value = displayFrequency;
+		return index == vr::k_unTrackedDeviceIndex_Hmd && displayFrequency > 0.0f;
+	case vr::Prop_SecondsFromVsyncToPhotons_Float:
+		value = 0.0f;
+		return index == vr::k_unTrackedDeviceIndex_Hmd;
+	case vr::Prop_DeviceBatteryPercentage_Float:
+		value = 1.0f;
+		return (int)index < numDevices;
+	default:
+		return false;
+	}
+}
+
+bool ofxViveTrackerSyntheticSource::pollNextEvent(vr::VREvent_t& event) {
+	double now = getTime();
+
+	memset(&event, 0, sizeof(event));
+	if (quitTime >= 0.0 && now >= quitTime && !quitSent) {
+		quitSent = true;
+		event.eventType = vr::VREvent_Quit;
+		event.trackedDeviceIndex = vr::k_unTrackedDeviceIndexInvalid;
+		return true;
+	}
+
+	for (int i = 0; i < numDevices; i++) {
+		bool connected = isConnectedAt(i, now);
+		if (connected == reportedConnected[i]) continue;
+		reportedConnected[i] = connected;
+		event.eventType = connected ? vr::VREvent_TrackedDeviceActivated : vr::VREvent_TrackedDeviceDeactivated;
+		event.trackedDeviceIndex = i;
+		return true;
+	}
+	return false;
+}
+
+bool ofxViveTrackerSyntheticSource::getTimeSinceLastVsync(float& secondsSinceVsync, uint64_t& frame) {
+	if (displayFrequency <= 0.0f) return false;
+	double now = getTime();
+	frame = uint64_t(now * displayFrequency);
+	secondsSinceVsync = float(now - frame / double(displayFrequency));
+	return true;
+}
+
+void ofxViveTrackerSyntheticSource::getPoses(vr::ETrackingUniverseOrigin origin, float predictedSeconds, vr::TrackedDevicePose_t* poses, uint32_t count) {
+	uint64_t sample = stepped ? step.fetch_add(1) : getSampleNumber();
+	double now = sample / double(rate);
+	double at = now + predictedSeconds;
+
+	for (uint32_t i = 0; i < count; i++) {
+		vr::TrackedDevicePose_t& p = poses[i];
+		memset(&p, 0, sizeof(p));
+		p.bDeviceIsConnected = isConnectedAt(i, now);
+		if (!p.bDeviceIsConnected) {
+			p.eTrackingResult = vr::TrackingResult_Uninitialized;
+			continue;
+		}
+
+		p.bPoseIsValid = !inWindow(dropouts, i, now);
+		p.eTrackingResult = p.bPoseIsValid ? vr::TrackingResult_Running_OK : vr::TrackingResult_Running_OutOfRange;
+		if (!p.bPoseIsValid) continue;
+
+		State state = trajectory(i, at);
+		if (noise > 0.0f) {
+			for (int axis = 0; axis < 3; axis++) {
+				state.position[axis] += getNoise(i, sample, axis);
+			}
+		}
+
+		ofxViveTrackerMath::toMatrix(state.orientation, state.position, p.mDeviceToAbsoluteTracking);
+
+		for (int axis = 0; axis < 3; axis++) {
+			p.vVelocity.v[axis] = state.velocity[axis];
+			p.vAngularVelocity.v[axis] = state.angularVelocity[axis];
+		}
+	}
+}
+
+uint64_t ofxViveTrackerSyntheticSource::getSampleNumber() const {
+	if (stepped) return step;
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return uint64_t(seconds * rate);
+}
+
+bool ofxViveTrackerSyntheticSource::isConnectedAt(vr::TrackedDeviceIndex_t index, double seconds) const {
+	return (int)index < numDevices && !inWindow(disconnects, index, seconds);
+}
+
+bool ofxViveTrackerSyntheticSource::inWindow(const std::vector<Window>& windows, vr::TrackedDeviceIndex_t index, double seconds) {
+	for (const auto& window : windows) {
+		if (window.index == index && seconds >= window.start && seconds < window.end) return true;
+	}
+	return false;
+}
+
+float ofxViveTrackerSyntheticSource::getNoise(vr::TrackedDeviceIndex_t index, uint64_t sample, int axis) const {
+	// splitmix64 of (seed, device, sample, axis): same input, same noise
+	uint64_t x = (uint64_t(seed) << 32) ^ (uint64_t(index) << 24) ^ (sample * 3 + axis);
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	x = x ^ (x >> 31);
+	return noise * (float(x >> 40) / float(1 << 24) * 2.0f - 1.0f);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxViveTrackerSource.h"
+#include <atomic>
+#include <functional>
+
+// Deterministic stand-in for SteamVR, for testing and benchmarking on
+// machines without a headset. Every device is a GenericTracker at indices
+// 0..numDevices-1 following a scripted trajectory. Dropouts (pose invalid)
+// and disconnects (device gone, with Activated/Deactivated events) are
+// scheduled in seconds since connect(). Configure before setup().
+class ofxViveTrackerSyntheticSource : public ofxViveTrackerSource {
+public:
+	struct State {
+		glm::vec3 position;
+		glm::quat orientation;
+		glm::vec3 velocity;
+		glm::vec3 angularVelocity;
+	};
+	typedef std::function<State(vr::TrackedDeviceIndex_t index, double seconds)> Trajectory;
+
+	ofxViveTrackerSyntheticSource();
+
+	void setNumDevices(int count);
+	// Poses change at this rate, like a real tracker's update rate.
+	void setRate(float hz);
+	void setDisplayFrequency(float hz);
+	// Advance time by 1/rate on every getPoses() instead of following
+	// steady_clock, so runs are repeatable and can go faster than real time.
+	void setStepped(bool stepped);
+	void setTrajectory(Trajectory trajectory);
+	// Uniform position noise in meters, reproducible for a given seed.
+	void setNoise(float meters, uint32_t seed = 0);
+	void addDropout(vr::TrackedDeviceIndex_t index, double start, double duration);
+	void addDisconnect(vr::TrackedDeviceIndex_t index, double start, double duration);
+	// Send VREvent_Quit this many seconds into every session (< 0 to disable).
+	void setQuitTime(double seconds);
+	// Make the next count calls to connect() fail.
+	void setConnectFailures(int count);
+
+	// Seconds since connect(), quantized to the rate.
+	double getTime() const;
+
+	// The default trajectory: every device circles at its own radius and speed.
+	static State circle(vr::TrackedDeviceIndex_t index, double seconds);
+
+	bool connect() override;
+	void disconnect() override;
+
+	bool isDeviceConnected(vr::TrackedDeviceIndex_t index) override;
+	vr::ETrackedDeviceClass getDeviceClass(vr::TrackedDeviceIndex_t index) override;
+	std::string getStringProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop) override;
+	bool getFloatProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty prop, float& value) override;
+
+	bool pollNextEvent(vr::VREvent_t& event) override;
+	bool getTimeSinceLastVsync(float& secondsSinceVsync, uint64_t& frame) override;
+	void getPoses(vr::ETrackingUniverseOrigin origin, float predictedSeconds, vr::TrackedDevicePose_t* poses, uint32_t count) override;
+
+private:
+	struct Window {
+		vr::TrackedDeviceIndex_t index;
+		double start;
+		double end;
+	};
+
+	int numDevices;
+	float rate;
+	float displayFrequency;
+	bool stepped;
+	Trajectory trajectory;
+	float noise;
+	uint32_t seed;
+	std::vector<Window> dropouts;
+	std::vector<Window> disconnects;
+	double quitTime;
+	int connectFailures;
+
+	std::chrono::steady_clock::time_point startTime;
+	std::atomic<uint64_t> step;
+	bool reportedConnected[vr::k_unMaxTrackedDeviceCount];
+	bool quitSent;
+
+	uint64_t getSampleNumber() const;
+	bool isConnectedAt(vr::TrackedDeviceIndex_t index, double seconds) const;
+	static bool inWindow(const std::vector<Window>& windows, vr::TrackedDeviceIndex_t index, double seconds);
+	float getNoise(vr::TrackedDeviceIndex_t index, uint64_t sample, int axis) const;
+};
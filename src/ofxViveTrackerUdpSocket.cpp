@@ -0,0 +1,224 @@
+#include "ofxViveTrackerUdpSocket.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+typedef SOCKET SocketHandle;
+static const SocketHandle invalidSocket = INVALID_SOCKET;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+static const SocketHandle invalidSocket = -1;
+#endif
+
+// Batch size for recvmmsg()
+static const size_t maxBatch = 64;
+
+struct ofxViveTrackerUdpSocket::Platform {
+	SocketHandle handle = invalidSocket;
+	std::vector<sockaddr_in> destinations;
+#ifdef __linux__
+	// Kept in step with destinations so send() doesn't build them each time
+	std::vector<mmsghdr> messages;
+	iovec sendVector;
+	mmsghdr receiveMessages[maxBatch];
+	iovec receiveVectors[maxBatch];
+#endif
+};
+
+static bool resolve(const std::string& host, int port, sockaddr_in& address) {
+	std::memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons((uint16_t) port);
+	if (host.empty()) {
+		address.sin_addr.s_addr = htonl(INADDR_ANY);
+		return true;
+	}
+	if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) == 1) {
+		return true;
+	}
+
+	addrinfo hints;
+	std::memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	addrinfo* result = nullptr;
+	if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+		return false;
+	}
+	address.sin_addr = ((sockaddr_in*) result->ai_addr)->sin_addr;
+	freeaddrinfo(result);
+	return true;
+}
+
+ofxViveTrackerUdpSocket::ofxViveTrackerUdpSocket()
+	: platform(new Platform()) {
+}
+
+ofxViveTrackerUdpSocket::~ofxViveTrackerUdpSocket() {
+	close();
+}
+
+bool ofxViveTrackerUdpSocket::open() {
+	close();
+#ifdef _WIN32
+	// Reference counted by Winsock, balanced in close()
+	WSADATA data;
+	if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+		return false;
+	}
+#endif
+	platform->handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (platform->handle == invalidSocket) {
+#ifdef _WIN32
+		WSACleanup();
+#endif
+		return false;
+	}
+
+	int enable = 1;
+	setsockopt(platform->handle, SOL_SOCKET, SO_BROADCAST, (const char*) &enable, sizeof(enable));
+	setsockopt(platform->handle, SOL_SOCKET, SO_REUSEADDR, (const char*) &enable, sizeof(enable));
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	ioctlsocket(platform->handle, FIONBIO, &nonBlocking);
+#else
+	fcntl(platform->handle, F_SETFL, fcntl(platform->handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+	return true;
+}
+
+bool ofxViveTrackerUdpSocket::bind(int port, const std::string& host) {
+	sockaddr_in address;
+	if (!isOpen() || !resolve(host, port, address)) {
+		return false;
+	}
+	return ::bind(platform->handle, (const sockaddr*) &address, sizeof(address)) == 0;
+}
+
+void ofxViveTrackerUdpSocket::close() {
+	if (platform->handle == invalidSocket) {
+		return;
+	}
+#ifdef _WIN32
+	closesocket(platform->handle);
+	WSACleanup();
+#else
+	::close(platform->handle);
+#endif
+	platform->handle = invalidSocket;
+}
+
+bool ofxViveTrackerUdpSocket::isOpen() const {
+	return platform->handle != invalidSocket;
+}
+
+bool ofxViveTrackerUdpSocket::addDestination(const std::string& host, int port) {
+	sockaddr_in address;
+	if (!resolve(host, port, address)) {
+		return false;
+	}
+	platform->destinations.push_back(address);
+#ifdef __linux__
+	// Rebuild the headers, the addresses may have moved
+	platform->messages.resize(platform->destinations.size());
+	for (size_t i = 0; i < platform->destinations.size(); i++) {
+		mmsghdr& message = platform->messages[i];
+		std::memset(&message, 0, sizeof(message));
+		message.msg_hdr.msg_name = &platform->destinations[i];
+		message.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		message.msg_hdr.msg_iov = &platform->sendVector;
+		message.msg_hdr.msg_iovlen = 1;
+	}
+#endif
+	return true;
+}
+
+void ofxViveTrackerUdpSocket::clearDestinations() {
+	platform->destinations.clear();
+#ifdef __linux__
+	platform->messages.clear();
+#endif
+}
+
+size_t ofxViveTrackerUdpSocket::getNumDestinations() const {
+	return platform->destinations.size();
+}
+
+size_t ofxViveTrackerUdpSocket::send(const void* data, size_t size) {
+	if (!isOpen() || platform->destinations.empty()) {
+		return 0;
+	}
+#ifdef __linux__
+	platform->sendVector.iov_base = const_cast<void*>(data);
+	platform->sendVector.iov_len = size;
+	int sent = sendmmsg(platform->handle, platform->messages.data(), (unsigned int) platform->messages.size(), 0);
+	return sent > 0 ? (size_t) sent : 0;
+#else
+	size_t sent = 0;
+	for (const sockaddr_in& address : platform->destinations) {
+		if (sendto(platform->handle, (const char*) data, (int) size, 0, (const sockaddr*) &address, sizeof(address)) == (int) size) {
+			sent++;
+		}
+	}
+	return sent;
+#endif
+}
+
+size_t ofxViveTrackerUdpSocket::receive(uint8_t* buffers, size_t bufferSize, size_t* sizes, size_t count) {
+	if (!isOpen()) {
+		return 0;
+	}
+#ifdef __linux__
+	size_t received = 0;
+	while (received < count) {
+		size_t batch = std::min(count - received, maxBatch);
+		for (size_t i = 0; i < batch; i++) {
+			iovec& vector = platform->receiveVectors[i];
+			vector.iov_base = buffers + (received + i) * bufferSize;
+			vector.iov_len = bufferSize;
+			mmsghdr& message = platform->receiveMessages[i];
+			std::memset(&message, 0, sizeof(message));
+			message.msg_hdr.msg_iov = &vector;
+			message.msg_hdr.msg_iovlen = 1;
+		}
+		int result = recvmmsg(platform->handle, platform->receiveMessages, (unsigned int) batch, MSG_DONTWAIT, nullptr);
+		if (result <= 0) {
+			break;
+		}
+		for (int i = 0; i < result; i++) {
+			sizes[received + i] = platform->receiveMessages[i].msg_len;
+		}
+		received += result;
+		if ((size_t) result < batch) {
+			break;
+		}
+	}
+	return received;
+#else
+	size_t received = 0;
+	for (; received < count; received++) {
+		int result = recv(platform->handle, (char*) (buffers + received * bufferSize), (int) bufferSize, 0);
+		if (result < 0) {
+			break;
+		}
+		sizes[received] = result;
+	}
+	return received;
+#endif
+}
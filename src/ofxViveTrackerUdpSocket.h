@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Minimal non-blocking IPv4 UDP socket, BSD sockets or Winsock. On Linux
+// sends and receives are batched with sendmmsg() and recvmmsg().
+class ofxViveTrackerUdpSocket {
+public:
+	ofxViveTrackerUdpSocket();
+	~ofxViveTrackerUdpSocket();
+
+	bool open();
+	// Listen on port, on every interface if host is empty.
+	bool bind(int port, const std::string& host = "");
+	void close();
+	bool isOpen() const;
+
+	// host may be a name, a unicast or a broadcast address.
+	bool addDestination(const std::string& host, int port);
+	void clearDestinations();
+	size_t getNumDestinations() const;
+
+	// Sends one datagram to every destination in a single system call where
+	// the platform allows it. Returns the number of destinations reached.
+	size_t send(const void* data, size_t size);
+
+	// Receives up to count waiting datagrams without blocking. Datagram i
+	// goes to buffers + i * bufferSize and its length to sizes[i]. Returns
+	// the number of datagrams received.
+	size_t receive(uint8_t* buffers, size_t bufferSize, size_t* sizes, size_t count);
+
+private:
+	struct Platform;
+	std::unique_ptr<Platform> platform;
+
+	ofxViveTrackerUdpSocket(const ofxViveTrackerUdpSocket&) = delete;
+	ofxViveTrackerUdpSocket& operator=(const ofxViveTrackerUdpSocket&) = delete;
+};